@@ -279,6 +279,46 @@ static inline void biphase_decode2(LTCDecoder *d, ltc_off_t offset, ltc_off_t po
 	d->biphase_prev = d->snd_to_biphase_state;
 }
 
+/* handle a biphase state change at sample i */
+static inline void biphase_edge(LTCDecoder *d, size_t i, ltc_off_t posinfo) {
+	/* If the sample count has risen above the biphase length limit */
+	if (d->snd_to_biphase_cnt > d->snd_to_biphase_lmt) {
+		/* single state change within a biphase priod. decode to a 0 */
+		biphase_decode2(d, i, posinfo);
+		biphase_decode2(d, i, posinfo);
+
+	} else {
+		/* "short" state change covering half a period
+		 * together with the next or previous state change decode to a 1
+		 */
+		d->snd_to_biphase_cnt *= 2;
+		biphase_decode2(d, i, posinfo);
+
+	}
+
+	if (d->snd_to_biphase_cnt > (d->snd_to_biphase_period * 4)) {
+		/* "long" silence in between
+		 * -> reset parser, don't use it for phase-tracking
+		 */
+		d->bit_cnt = 0;
+	} else  {
+		/* track speed variations
+		 * As this is only executed at a state change,
+		 * d->snd_to_biphase_cnt is an accurate representation of the current period length.
+		 */
+		d->snd_to_biphase_period = (d->snd_to_biphase_period * 3.0 + d->snd_to_biphase_cnt) / 4.0;
+
+		/* This limit specifies when a state-change is
+		 * considered biphase-clock or 2*biphase-clock.
+		 * The relation with period has been determined
+		 * empirically through trial-and-error */
+		d->snd_to_biphase_lmt = (d->snd_to_biphase_period * 3) / 4;
+	}
+
+	d->snd_to_biphase_cnt = 0;
+	d->snd_to_biphase_state = !d->snd_to_biphase_state;
+}
+
 void decode_ltc(LTCDecoder *d, ltcsnd_sample_t *sound, size_t size, ltc_off_t posinfo) {
 	size_t i;
 
@@ -302,44 +342,141 @@ void decode_ltc(LTCDecoder *d, ltcsnd_sample_t *sound, size_t size, ltc_off_t po
 			   (  d->snd_to_biphase_state && (sound[i] > max_threshold) )
 			|| ( !d->snd_to_biphase_state && (sound[i] < min_threshold) )
 		   ) {
+			biphase_edge(d, i, posinfo);
+		}
+		d->snd_to_biphase_cnt++;
+	}
+}
+
+/* -+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * Batched decoder: the envelope follower and edge detection of
+ * LTC_BATCH_GROUP lanes run in lockstep over struct-of-arrays state, with
+ * fixed trip counts and no branches, so the compiler vectorizes them
+ * across lanes. Each group runs over the whole buffer while its state
+ * stays in registers. The rare lanes with a state change fall back to the
+ * scalar bit parser of their own LTCDecoder.
+ */
+
+static void batch_lane_edge(LTCBatchDecoder *b, LTCBatchGroup *g, int first, int k, size_t i, ltc_off_t posinfo) {
+	const int l = first + k;
+	LTCDecoder *d = b->lane[l];
+	d->snd_to_biphase_min = g->min[k];
+	d->snd_to_biphase_max = g->max[k];
+	d->snd_to_biphase_state = g->state[k];
+	d->snd_to_biphase_cnt = g->cnt[k] - 1;
+	d->snd_to_biphase_lmt = b->lmt[l];
+	d->snd_to_biphase_period = b->period[l];
+
+	biphase_edge(d, i, posinfo);
+
+	g->state[k] = d->snd_to_biphase_state;
+	g->cnt[k] = d->snd_to_biphase_cnt + 1;
+	b->lmt[l] = d->snd_to_biphase_lmt;
+	b->period[l] = d->snd_to_biphase_period;
+}
+
+/* one sample of every lane in the group, non-zero if any lane has an edge */
+static inline int batch_group_step(LTCBatchGroup *g, const short *s) {
+	int k, any = 0;
+	/* same arithmetic as decode_ltc(); all terms are >= 0 so /16 is >> 4 */
+	for (k = 0 ; k < LTC_BATCH_GROUP ; k++) {
+		const int in = s[k];
+		int mn = SAMPLE_CENTER - (((SAMPLE_CENTER - g->min[k]) * 15) >> 4);
+		int mx = SAMPLE_CENTER + (((g->max[k] - SAMPLE_CENTER) * 15) >> 4);
+		mn = (in < mn) ? in : mn;
+		mx = (in > mx) ? in : mx;
+		g->min[k] = mn;
+		g->max[k] = mx;
+
+		const int min_threshold = SAMPLE_CENTER - (((SAMPLE_CENTER - mn) * 8) >> 4);
+		const int max_threshold = SAMPLE_CENTER + (((mx - SAMPLE_CENTER) * 8) >> 4);
+		const int state = g->state[k];
+		const int e = (state & (in > max_threshold)) | ((state ^ 1) & (in < min_threshold));
+		g->edge[k] = e;
+		g->cnt[k]++;
+		any |= e;
+	}
+	return any;
+}
 
-			/* If the sample count has risen above the biphase length limit */
-			if (d->snd_to_biphase_cnt > d->snd_to_biphase_lmt) {
-				/* single state change within a biphase priod. decode to a 0 */
-				biphase_decode2(d, i, posinfo);
-				biphase_decode2(d, i, posinfo);
+static void decode_ltc_batch_group(LTCBatchDecoder *b, int group, ltcsnd_sample_t *sound, size_t size, size_t stride, ltc_off_t posinfo) {
+	const int first = group * LTC_BATCH_GROUP;
+	const int n = (b->lanes - first < LTC_BATCH_GROUP) ? b->lanes - first : LTC_BATCH_GROUP;
+	LTCBatchGroup g = b->group[group];
+	short s[LTC_BATCH_GROUP];
+	size_t i;
+	int k;
 
-			} else {
-				/* "short" state change covering half a period
-				 * together with the next or previous state change decode to a 1
-				 */
-				d->snd_to_biphase_cnt *= 2;
-				biphase_decode2(d, i, posinfo);
+	for (k = 0 ; k < LTC_BATCH_GROUP ; k++) {
+		s[k] = SAMPLE_CENTER;
+	}
 
+	for (i = 0 ; i < size ; i++) {
+		const ltcsnd_sample_t *in = &sound[i * stride + first];
+		if (n == LTC_BATCH_GROUP) {
+			for (k = 0 ; k < LTC_BATCH_GROUP ; k++) {
+				s[k] = in[k];
 			}
+		} else {
+			for (k = 0 ; k < n ; k++) {
+				s[k] = in[k];
+			}
+		}
 
-			if (d->snd_to_biphase_cnt > (d->snd_to_biphase_period * 4)) {
-				/* "long" silence in between
-				 * -> reset parser, don't use it for phase-tracking
-				 */
-				d->bit_cnt = 0;
-			} else  {
-				/* track speed variations
-				 * As this is only executed at a state change,
-				 * d->snd_to_biphase_cnt is an accurate representation of the current period length.
-				 */
-				d->snd_to_biphase_period = (d->snd_to_biphase_period * 3.0 + d->snd_to_biphase_cnt) / 4.0;
-
-				/* This limit specifies when a state-change is
-				 * considered biphase-clock or 2*biphase-clock.
-				 * The relation with period has been determined
-				 * empirically through trial-and-error */
-				d->snd_to_biphase_lmt = (d->snd_to_biphase_period * 3) / 4;
+		if (batch_group_step(&g, s)) {
+			int w;
+			for (w = 0 ; w < LTC_BATCH_GROUP ; w += 8) {
+				unsigned long long bits;
+				memcpy(&bits, &g.edge[w], sizeof(bits));
+#if defined __GNUC__ && defined __BYTE_ORDER__ && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+				/* only the lanes with an edge, lowest first */
+				while (bits) {
+					k = w + (__builtin_ctzll(bits) >> 3);
+					bits &= bits - 1;
+					if (k < n) batch_lane_edge(b, &g, first, k, i, posinfo);
+				}
+#else
+				if (bits) {
+					for (k = w ; k < w + 8 && k < n ; k++) {
+						if (g.edge[k]) batch_lane_edge(b, &g, first, k, i, posinfo);
+					}
+				}
+#endif
 			}
+		}
+	}
+	b->group[group] = g;
+}
 
-			d->snd_to_biphase_cnt = 0;
-			d->snd_to_biphase_state = !d->snd_to_biphase_state;
+/* few lanes: the padding of a group costs more than it saves, deinterleave
+ * and run the scalar decoder of each lane. the group state is not used.
+ */
+static void decode_ltc_batch_scalar(LTCBatchDecoder *b, ltcsnd_sample_t *sound, size_t size, size_t stride, ltc_off_t posinfo) {
+	ltcsnd_sample_t lane[1024];
+	const size_t len = sizeof(lane) / sizeof(lane[0]);
+	size_t off, i;
+	int l;
+
+	for (off = 0 ; off < size ; off += len) {
+		const size_t c = (size - off < len) ? size - off : len;
+		for (l = 0 ; l < b->lanes ; l++) {
+			const ltcsnd_sample_t *in = &sound[off * stride + l];
+			for (i = 0 ; i < c ; i++) {
+				lane[i] = in[i * stride];
+			}
+			decode_ltc(b->lane[l], lane, c, posinfo + (ltc_off_t)off);
 		}
-		d->snd_to_biphase_cnt++;
+	}
+}
+
+void decode_ltc_batch(LTCBatchDecoder *b, ltcsnd_sample_t *sound, size_t size, size_t stride, ltc_off_t posinfo) {
+	int group;
+	if (b->lanes < LTC_BATCH_MIN_LANES) {
+		decode_ltc_batch_scalar(b, sound, size, stride, posinfo);
+		return;
+	}
+	/* the lanes are independent: each group in turn over the whole buffer */
+	for (group = 0 ; group < b->groups ; group++) {
+		decode_ltc_batch_group(b, group, sound, size, stride, posinfo);
 	}
 }
@@ -51,4 +51,32 @@ struct LTCDecoder {
 };
 
 
+#define LTC_BATCH_GROUP 16 ///< lanes stepped together
+#define LTC_BATCH_MIN_LANES 8 ///< below this each lane runs decode_ltc() on its own
+
+/* envelope / edge tracking of LTC_BATCH_GROUP lanes, struct-of-arrays.
+ * lanes past the last real one idle at SAMPLE_CENTER and never see an edge.
+ */
+typedef struct LTCBatchGroup {
+	short min[LTC_BATCH_GROUP];
+	short max[LTC_BATCH_GROUP];
+	short state[LTC_BATCH_GROUP];
+	unsigned char edge[LTC_BATCH_GROUP]; ///< scanned 8 lanes at a time
+	int cnt[LTC_BATCH_GROUP]; ///< one ahead of snd_to_biphase_cnt, counts the sample being looked at
+} LTCBatchGroup;
+
+struct LTCBatchDecoder {
+	int lanes;
+	LTCDecoder **lane; ///< per lane bit parser and frame queue
+
+	int groups; ///< lanes / LTC_BATCH_GROUP, rounded up
+	LTCBatchGroup *group;
+	int *lmt; ///< per lane, only used at edges
+	double *period;
+
+	ltcsnd_sample_t *conv; ///< scratch for sample format conversion
+};
+
+
 void decode_ltc(LTCDecoder *d, ltcsnd_sample_t *sound, size_t size, ltc_off_t posinfo);
+void decode_ltc_batch(LTCBatchDecoder *b, ltcsnd_sample_t *sound, size_t size, size_t stride, ltc_off_t posinfo);
@@ -25,6 +25,63 @@
 
 #include "encoder.h"
 
+size_t encode_sample_size(enum LTC_SAMPLE_FORMAT format) {
+	switch (format) {
+		case LTC_SAMPLE_U8: return sizeof(ltcsnd_sample_t);
+		case LTC_SAMPLE_FLOAT: return sizeof(float);
+		case LTC_SAMPLE_S16: return sizeof(short);
+		case LTC_SAMPLE_S32: return sizeof(int);
+	}
+	return 0;
+}
+
+/**
+ * store one sample of the float, s16 or s32 output,
+ * val is in units of the format's full scale
+ */
+static void put_sample(LTCEncoder *e, unsigned char *out, double val) {
+	switch (e->format) {
+		case LTC_SAMPLE_FLOAT:
+			{ const float v = val; memcpy(out, &v, sizeof(v)); }
+			break;
+		case LTC_SAMPLE_S16:
+			{ const short v = lrint(val); memcpy(out, &v, sizeof(v)); }
+			break;
+		case LTC_SAMPLE_S32:
+			{ const int v = lrint(val); memcpy(out, &v, sizeof(v)); }
+			break;
+		default:
+			*out = val;
+			break;
+	}
+}
+
+/** full scale of the float, s16 and s32 output */
+static double full_scale(enum LTC_SAMPLE_FORMAT format) {
+	switch (format) {
+		case LTC_SAMPLE_S16: return 32767.0;
+		case LTC_SAMPLE_S32: return 2147483647.0;
+		default: return 1.0;
+	}
+}
+
+/**
+ * repeat the sample at value n times, doubling the copied run
+ */
+static void fill_samples(unsigned char *out, const unsigned char *value, size_t n, size_t sample_size) {
+	size_t done, total = n * sample_size;
+	if (n == 0)
+		return;
+	if (sample_size == 1) {
+		memset(out, *value, n);
+		return;
+	}
+	memcpy(out, value, sample_size);
+	for (done = sample_size; done < total; done *= 2) {
+		memcpy(out + done, out, (done < total - done) ? done : total - done);
+	}
+}
+
 /**
  * add values to the output buffer
  */
@@ -38,9 +95,23 @@ static int addvalues(LTCEncoder *e, int n) {
 		return 1;
 	}
 
-	ltcsnd_sample_t * const wave = &(e->buf[e->offset]);
+	const size_t ss = e->sample_size;
+	unsigned char * const wave = &(e->buf[e->offset * ss]);
 	const double tcf =  e->filter_const;
-	if (tcf > 0) {
+	const int s = e->state ? 1 : 0;
+	const int len = e->edge_len[s];
+	if (tcf > 0 && len >= 0) {
+		/* assembled from the templates, see encode_prepare_edges() */
+		const int m = (n+1)>>1;
+		if (m <= len) {
+			memcpy(wave, e->edge_rise[s], m * ss);
+			memcpy(wave + (n - m) * ss, e->edge_fall[s] + (len - m) * ss, m * ss);
+		} else {
+			memcpy(wave, e->edge_rise[s], len * ss);
+			fill_samples(wave + len * ss, e->edge_rise[s] + len * ss, n - 2 * len, ss);
+			memcpy(wave + (n - len) * ss, e->edge_fall[s], len * ss);
+		}
+	} else if (tcf > 0 && e->format == LTC_SAMPLE_U8) {
 		/* low-pass-filter
 		 * LTC signal should have a rise time of 40 us +/- 10 us.
 		 *
@@ -57,15 +128,253 @@ static int addvalues(LTCEncoder *e, int n) {
 			val = val + tcf * (tgtval - val);
 			wave[n-i-1] = wave[i] = val;
 		}
+	} else if (tcf > 0) {
+		/* the same filter without 8 bit truncation, from 0 */
+		const double tgt = (e->state ? 1.0 : -1.0) * e->amplitude * full_scale(e->format);
+		double val = 0;
+		int i;
+		int m = (n+1)>>1;
+		for (i = 0 ; i < m ; i++) {
+			val = val + tcf * (tgt - val);
+			put_sample(e, wave + i * ss, val);
+			memcpy(wave + (n - i - 1) * ss, wave + i * ss, ss);
+		}
 	} else {
 		/* perfect square wave */
-		memset(wave, tgtval, n);
+		fill_samples(wave, e->level[s], n, ss);
 	}
 
 	e->offset += n;
 	return 0;
 }
 
+/**
+ * precompute the levels and the filtered edges addvalues() copies from.
+ * the filter starts at the center for every half-bit, so the first half
+ * of each one is the same sequence for a given level, whatever its length.
+ * it settles at a fixed value after a few samples: the 8 bit output by
+ * truncation, the others once they round to the level itself.
+ */
+void encode_prepare_edges(LTCEncoder *e) {
+	const double tcf = e->filter_const;
+	const size_t ss = e->sample_size;
+	int s;
+	for (s = 0; s < 2; s++) {
+		const ltcsnd_sample_t tgtval = s ? e->enc_hi : e->enc_lo;
+		const double tgt = (s ? 1.0 : -1.0) * e->amplitude * full_scale(e->format);
+		unsigned char * const rise = e->edge_rise[s];
+		int i, len = -1;
+		if (e->format == LTC_SAMPLE_U8)
+			e->level[s][0] = tgtval;
+		else
+			put_sample(e, e->level[s], tgt);
+		e->edge_len[s] = -1;
+		if (tcf <= 0)
+			continue;
+		if (e->format == LTC_SAMPLE_U8) {
+			ltcsnd_sample_t val = SAMPLE_CENTER;
+			for (i = 0; i < LTC_EDGE_MAX; i++) {
+				val = val + tcf * (tgtval - val);
+				rise[i] = val;
+				if (i > 0 && rise[i - 1] == val) {
+					len = i - 1;
+					break;
+				}
+			}
+		} else {
+			double val = 0;
+			for (i = 0; i < LTC_EDGE_MAX; i++) {
+				val = val + tcf * (tgt - val);
+				put_sample(e, rise + i * ss, val);
+				if (!memcmp(rise + i * ss, e->level[s], ss)) {
+					len = i;
+					break;
+				}
+			}
+			e->edge_tail[s] = val;
+		}
+		if (len < 0)
+			continue;
+		for (i = 0; i < len; i++) {
+			memcpy(e->edge_fall[s] + (len - 1 - i) * ss, rise + i * ss, ss);
+		}
+		e->edge_len[s] = len;
+	}
+}
+
+/**
+ * sample k of the current half-bit of n samples, for the filtered
+ * output where the edge doesn't settle within LTC_EDGE_MAX samples.
+ * computed like addvalues() does, continuing from the end of edge_rise.
+ */
+static void slow_sample(LTCEncoder *e, int n, int k, unsigned char *out) {
+	const double tcf = e->filter_const;
+	const int s = e->state ? 1 : 0;
+	const size_t ss = e->sample_size;
+	const int idx = (k < n - 1 - k) ? k : n - 1 - k;
+	int i;
+	if (idx < LTC_EDGE_MAX) {
+		memcpy(out, e->edge_rise[s] + idx * ss, ss);
+	} else if (e->format == LTC_SAMPLE_U8) {
+		const ltcsnd_sample_t tgtval = s ? e->enc_hi : e->enc_lo;
+		ltcsnd_sample_t val = e->edge_rise[s][LTC_EDGE_MAX - 1];
+		for (i = LTC_EDGE_MAX; i <= idx; i++) {
+			val = val + tcf * (tgtval - val);
+		}
+		*out = val;
+	} else {
+		const double tgt = (s ? 1.0 : -1.0) * e->amplitude * full_scale(e->format);
+		double val = e->edge_tail[s];
+		for (i = LTC_EDGE_MAX; i <= idx; i++) {
+			val = val + tcf * (tgt - val);
+		}
+		put_sample(e, out, val);
+	}
+}
+
+/**
+ * copy count samples to every stride'th sample of out,
+ * from consecutive samples of src or (step 0) the same one
+ */
+static void put_samples(unsigned char *out, int stride, const unsigned char *src, int step, int count, size_t ss) {
+	int i;
+	switch (ss) {
+		case 1:
+			for (i = 0; i < count; i++) {
+				out[i * stride] = src[i * step];
+			}
+			break;
+		case 2:
+			for (i = 0; i < count; i++) {
+				memcpy(out + (size_t) i * stride * 2, src + i * step * 2, 2);
+			}
+			break;
+		default:
+			for (i = 0; i < count; i++) {
+				memcpy(out + (size_t) i * stride * 4, src + i * step * 4, 4);
+			}
+			break;
+	}
+}
+
+/**
+ * write samples [from, to) of the current half-bit to out, with stride.
+ * the same values addvalues() produces for the whole of it.
+ */
+static void write_run(LTCEncoder *e, unsigned char *out, int stride, int from, int to) {
+	const int n = e->run_len;
+	const int s = e->state ? 1 : 0;
+	const int len = e->edge_len[s];
+	const size_t ss = e->sample_size;
+	int a, b, c0, k;
+
+	if (e->filter_const > 0 && len < 0) {
+		for (k = from; k < to; k++) {
+			slow_sample(e, n, k, out + (size_t) (k - from) * stride * ss);
+		}
+		return;
+	}
+
+	/* rising part [0, a) from edge_rise, level [a, b), falling part [b, n) from edge_fall */
+	if (e->filter_const <= 0) {
+		a = 0; b = n; c0 = 0;
+	} else if ((n+1)>>1 <= len) {
+		a = b = (n+1)>>1; c0 = len - n + a;
+	} else {
+		a = len; b = n - len; c0 = 0;
+	}
+
+	k = from;
+	if (k < a && k < to) {
+		const int end = (a < to) ? a : to;
+		put_samples(out, stride, e->edge_rise[s] + k * ss, 1, end - k, ss);
+		out += (size_t) (end - k) * stride * ss;
+		k = end;
+	}
+	if (k < b && k < to) {
+		const int end = (b < to) ? b : to;
+		const unsigned char *level = (e->filter_const > 0) ? e->edge_rise[s] + len * ss : e->level[s];
+		put_samples(out, stride, level, 0, end - k, ss);
+		out += (size_t) (end - k) * stride * ss;
+		k = end;
+	}
+	if (k < to) {
+		put_samples(out, stride, e->edge_fall[s] + (c0 + k - b) * ss, 1, to - k, ss);
+	}
+}
+
+void encode_reset_position(LTCEncoder *e) {
+	e->frame_bit = 0;
+	e->half = 0;
+	e->run_len = -1;
+	e->run_pos = 0;
+	e->frame_pos = 0;
+}
+
+/**
+ * encode up to size samples of the current frame at speed 1.0, continuing
+ * where the last call stopped. same output and remainder handling as
+ * encode_byte() for bytes 0..9. stops at the end of the frame.
+ */
+int encode_samples(LTCEncoder *e, unsigned char *out, int size, int stride) {
+	const size_t step = (size_t) stride * e->sample_size;
+	int done = 0;
+
+	while (done < size) {
+		const unsigned char c = ((unsigned char*)&e->f)[e->frame_bit / 8];
+		const int one = (c >> (e->frame_bit % 8)) & 1;
+
+		if (e->run_len < 0) {
+			const int n = encode_run_length(e, one ? 1 : 2, 1.0);
+			e->state = !e->state;
+			e->run_len = n;
+			e->run_pos = 0;
+		}
+
+		int count = e->run_len - e->run_pos;
+		if (count > size - done)
+			count = size - done;
+		if (count > 0) {
+			write_run(e, out + done * step, stride, e->run_pos, e->run_pos + count);
+			e->run_pos += count;
+			e->frame_pos += count;
+			done += count;
+		}
+
+		if (e->run_pos == e->run_len) {
+			e->run_len = -1;
+			if (one && !e->half) {
+				e->half = 1;
+			} else {
+				e->half = 0;
+				if (++e->frame_bit == LTC_FRAME_BIT_COUNT) {
+					e->frame_bit = 0;
+					e->frame_pos = 0;
+					break;
+				}
+			}
+		}
+	}
+	return done;
+}
+
+/**
+ * samples of the next run of halves (1 or 2) half-bits, advancing the
+ * fractional sample position. exact at speed +-1 when the encoder has
+ * the half-bit length as a fraction, so frames never drift.
+ */
+int encode_run_length(LTCEncoder *e, int halves, double speed) {
+	if (e->half_den && fabs(speed) == 1.0) {
+		const long long total = e->half_remainder + halves * e->half_num;
+		e->half_remainder = total % e->half_den;
+		return (int)(total / e->half_den);
+	}
+	const double spb = (halves == 2 ? e->samples_per_clock : e->samples_per_clock_2) * fabs(speed);
+	const int n = (int)(spb + e->sample_remainder);
+	e->sample_remainder = spb + e->sample_remainder - n;
+	return n;
+}
+
 int encode_byte(LTCEncoder *e, int byte, double speed) {
 	if (byte < 0 || byte > 9) return -1;
 	if (speed ==0) return -1;
@@ -73,25 +382,20 @@ int encode_byte(LTCEncoder *e, int byte, double speed) {
 	int err = 0;
 	const unsigned char c = ((unsigned char*)&e->f)[byte];
 	unsigned char b = (speed < 0)?128:1; // bit
-	const double spc = e->samples_per_clock * fabs(speed);
-	const double sph = e->samples_per_clock_2 * fabs(speed);
 
 	do
 	{
 		int n;
 		if ((c & b) == 0) {
-			n = (int)(spc + e->sample_remainder);
-			e->sample_remainder = spc + e->sample_remainder - n;
+			n = encode_run_length(e, 2, speed);
 			e->state = !e->state;
 			err |= addvalues(e, n);
 		} else {
-			n = (int)(sph + e->sample_remainder);
-			e->sample_remainder = sph + e->sample_remainder - n;
+			n = encode_run_length(e, 1, speed);
 			e->state = !e->state;
 			err |= addvalues(e, n);
 
-			n = (int)(sph + e->sample_remainder);
-			e->sample_remainder = sph + e->sample_remainder - n;
+			n = encode_run_length(e, 1, speed);
 			e->state = !e->state;
 			err |= addvalues(e, n);
 		}
@@ -23,6 +23,9 @@
 #define SAMPLE_CENTER 128 // unsigned 8 bit.
 #endif
 
+#define LTC_EDGE_MAX 256 // longest filtered edge kept as a template
+#define LTC_SAMPLE_SIZE_MAX 4 // bytes of the widest output sample format
+
 struct LTCEncoder {
 	double fps;
 	double sample_rate;
@@ -30,10 +33,13 @@ struct LTCEncoder {
 	int flags;
 	enum LTC_TV_STANDARD standard;
 	ltcsnd_sample_t enc_lo, enc_hi;
+	double amplitude; // of the float, s16 and s32 output, 1.0 is full scale
+	enum LTC_SAMPLE_FORMAT format;
+	size_t sample_size; // bytes per sample of format
 
-	size_t offset;
-	size_t bufsize;
-	ltcsnd_sample_t *buf;
+	size_t offset; // in samples
+	size_t bufsize; // in samples
+	ltcsnd_sample_t *buf; // bufsize * sample_size bytes
 
 	char state;
 
@@ -41,7 +47,39 @@ struct LTCEncoder {
 	double samples_per_clock_2;
 	double sample_remainder;
 
+	/* a half-bit is exactly half_num / half_den samples when the sample rate
+	 * and fps are fractions the encoder knows (see ltc_encoder_set_exact_rate);
+	 * half_remainder is the fractional sample position in 1 / half_den.
+	 * half_den 0: samples_per_clock_2 and sample_remainder are used instead.
+	 */
+	long long half_num;
+	long long half_den;
+	long long half_remainder;
+
 	LTCFrame f;
+
+	/* the low-pass filtered half of a half-bit towards the low [0] and high [1]
+	 * level, as addvalues() would compute it, and the same reversed, in the
+	 * output format. edge_len is where the edge settles at sample edge_len of
+	 * edge_rise[], -1 if it doesn't. level[] holds the unfiltered levels.
+	 */
+	unsigned char edge_rise[2][LTC_EDGE_MAX * LTC_SAMPLE_SIZE_MAX];
+	unsigned char edge_fall[2][LTC_EDGE_MAX * LTC_SAMPLE_SIZE_MAX];
+	int edge_len[2];
+	unsigned char level[2][LTC_SAMPLE_SIZE_MAX];
+	double edge_tail[2]; // filter state after an edge that doesn't settle
+
+	/* where ltc_encoder_encode_samples() is in the frame */
+	int frame_bit; // 0 .. LTC_FRAME_BIT_COUNT - 1
+	int half; // in the second half of a '1' bit
+	int run_len; // samples of the current (half-)bit, -1 before it starts
+	int run_pos; // of which written
+	size_t frame_pos; // samples of the frame written
 };
 
 int encode_byte(LTCEncoder *e, int byte, double speed);
+int encode_run_length(LTCEncoder *e, int halves, double speed);
+void encode_prepare_edges(LTCEncoder *e);
+int encode_samples(LTCEncoder *e, unsigned char *out, int size, int stride);
+void encode_reset_position(LTCEncoder *e);
+size_t encode_sample_size(enum LTC_SAMPLE_FORMAT format);
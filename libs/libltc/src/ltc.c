@@ -68,6 +68,20 @@ int ltc_decoder_free(LTCDecoder *d) {
 	return 0;
 }
 
+LTCDecoder* ltc_decoder_copy(const LTCDecoder *d) {
+	LTCDecoder* c = (LTCDecoder*) malloc(sizeof(LTCDecoder));
+	if (!c) return NULL;
+
+	memcpy(c, d, sizeof(LTCDecoder));
+	c->queue = (LTCFrameExt*) malloc(d->queue_len * sizeof(LTCFrameExt));
+	if (!c->queue) {
+		free(c);
+		return NULL;
+	}
+	memcpy(c->queue, d->queue, d->queue_len * sizeof(LTCFrameExt));
+	return c;
+}
+
 void ltc_decoder_write(LTCDecoder *d, ltcsnd_sample_t *buf, size_t size, ltc_off_t posinfo) {
 	decode_ltc(d, buf, size, posinfo);
 }
@@ -96,8 +110,6 @@ LTCWRITE_TEMPLATE(s16, short, 128 + (buf[copyStart+i] >> 8))
 /* this relies on the compiler to use a logical right-shift for unsigned values */
 LTCWRITE_TEMPLATE(u16, unsigned short, (buf[copyStart+i] >> 8))
 
-#undef LTC_CONVERSION_BUF_SIZE
-
 int ltc_decoder_read(LTCDecoder* d, LTCFrameExt* frame) {
 	if (!frame) return -1;
 	if (d->queue_read_off != d->queue_write_off) {
@@ -122,10 +134,196 @@ int ltc_decoder_queue_length(LTCDecoder* d) {
 	return (d->queue_write_off - d->queue_read_off + d->queue_len) % d->queue_len;
 }
 
+/* -+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * Batched decoder
+ */
+
+LTCBatchDecoder* ltc_batch_decoder_create(int lanes, int apv, int queue_len) {
+	int l;
+	if (lanes < 1) return NULL;
+
+	LTCBatchDecoder* b = (LTCBatchDecoder*) calloc(1, sizeof(LTCBatchDecoder));
+	if (!b) return NULL;
+
+	b->lanes = lanes;
+	b->groups = (lanes + LTC_BATCH_GROUP - 1) / LTC_BATCH_GROUP;
+	b->lane = (LTCDecoder**) calloc(lanes, sizeof(LTCDecoder*));
+	b->group = (LTCBatchGroup*) calloc(b->groups, sizeof(LTCBatchGroup));
+	b->lmt = (int*) calloc(lanes, sizeof(int));
+	b->period = (double*) calloc(lanes, sizeof(double));
+	b->conv = (ltcsnd_sample_t*) calloc((size_t)lanes * LTC_CONVERSION_BUF_SIZE, sizeof(ltcsnd_sample_t));
+	if (!b->lane || !b->group || !b->lmt || !b->period || !b->conv) {
+		ltc_batch_decoder_free(b);
+		return NULL;
+	}
+
+	for (l = 0; l < b->groups * LTC_BATCH_GROUP; l++) {
+		LTCBatchGroup *g = &b->group[l / LTC_BATCH_GROUP];
+		g->min[l % LTC_BATCH_GROUP] = SAMPLE_CENTER;
+		g->max[l % LTC_BATCH_GROUP] = SAMPLE_CENTER;
+	}
+
+	for (l = 0; l < lanes; l++) {
+		LTCDecoder *d = ltc_decoder_create(apv, queue_len);
+		if (!d) {
+			ltc_batch_decoder_free(b);
+			return NULL;
+		}
+		b->lane[l] = d;
+		LTCBatchGroup *g = &b->group[l / LTC_BATCH_GROUP];
+		g->min[l % LTC_BATCH_GROUP] = d->snd_to_biphase_min;
+		g->max[l % LTC_BATCH_GROUP] = d->snd_to_biphase_max;
+		g->state[l % LTC_BATCH_GROUP] = d->snd_to_biphase_state;
+		g->cnt[l % LTC_BATCH_GROUP] = d->snd_to_biphase_cnt;
+		b->lmt[l] = d->snd_to_biphase_lmt;
+		b->period[l] = d->snd_to_biphase_period;
+	}
+	return b;
+}
+
+int ltc_batch_decoder_free(LTCBatchDecoder *b) {
+	int l;
+	if (!b) return 1;
+	if (b->lane) {
+		for (l = 0; l < b->lanes; l++) {
+			ltc_decoder_free(b->lane[l]);
+		}
+		free(b->lane);
+	}
+	free(b->group);
+	free(b->lmt);
+	free(b->period);
+	free(b->conv);
+	free(b);
+
+	return 0;
+}
+
+int ltc_batch_decoder_lanes(LTCBatchDecoder *b) {
+	return b->lanes;
+}
+
+void ltc_batch_decoder_write(LTCBatchDecoder *b, ltcsnd_sample_t *buf, size_t size, size_t stride, ltc_off_t posinfo) {
+	decode_ltc_batch(b, buf, size, stride, posinfo);
+}
+
+void ltc_batch_decoder_write_float(LTCBatchDecoder *b, float *buf, size_t size, size_t stride, ltc_off_t posinfo) {
+	const int lanes = b->lanes;
+	size_t copyStart = 0;
+	while (copyStart < size) {
+		size_t i;
+		int l;
+		size_t c = size - copyStart;
+		c = (c > LTC_CONVERSION_BUF_SIZE) ? LTC_CONVERSION_BUF_SIZE : c;
+		if (lanes < LTC_BATCH_MIN_LANES) {
+			/* convert and deinterleave in one pass for the scalar decoders */
+			for (l = 0; l < lanes; l++) {
+				for (i = 0; i < c; i++) {
+					b->conv[i] = 128 + (buf[(copyStart + i) * stride + l] * 127.0);
+				}
+				decode_ltc(b->lane[l], b->conv, c, posinfo + (ltc_off_t)copyStart);
+			}
+			copyStart += c;
+			continue;
+		}
+		for (i = 0; i < c; i++) {
+			const float *in = &buf[(copyStart + i) * stride];
+			ltcsnd_sample_t *out = &b->conv[i * lanes];
+			/* whole groups with a fixed trip count, which vectorizes */
+			for (l = 0; l + LTC_BATCH_GROUP <= lanes; l += LTC_BATCH_GROUP) {
+				int k;
+				for (k = 0; k < LTC_BATCH_GROUP; k++) {
+					out[l + k] = 128 + (in[l + k] * 127.0);
+				}
+			}
+			for (; l < lanes; l++) {
+				out[l] = 128 + (in[l] * 127.0);
+			}
+		}
+		decode_ltc_batch(b, b->conv, c, lanes, posinfo + (ltc_off_t)copyStart);
+		copyStart += c;
+	}
+}
+
+int ltc_batch_decoder_read(LTCBatchDecoder *b, int lane, LTCFrameExt *frame) {
+	if (lane < 0 || lane >= b->lanes) return 0;
+	return ltc_decoder_read(b->lane[lane], frame);
+}
+
+#undef LTC_CONVERSION_BUF_SIZE
+
 /* -+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  * Encoder
  */
 
+static long long gcd(long long a, long long b) {
+	while (b) {
+		const long long t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/* rate as num / den: whole numbers, n * 1000 / 1001 (23.976, 29.97,
+ * 47952.048 ..) and whole thousandths. 0 if it is none of them.
+ */
+static int rate_ratio(double rate, long long *num, long long *den) {
+	if (rate <= 0 || rate > 1e9)
+		return 0;
+	if (fabs(rate - rint(rate)) < 1e-6) {
+		*num = (long long) rint(rate);
+		*den = 1;
+		return 1;
+	}
+	/* N / 1.001 written as N * 0.999 (29.97, 23.976, 59.94) is 1e-6 off,
+	 * anything further away is not a pulled down rate */
+	const double pulled = rint(rate * 1.001);
+	if (fabs(rate - pulled * 1000.0 / 1001.0) < 2e-6 * rate) {
+		*num = (long long) pulled * 1000;
+		*den = 1001;
+		return 1;
+	}
+	if (fabs(rate - rint(rate * 1000.0) / 1000.0) < 1e-9 * rate) {
+		*num = (long long) rint(rate * 1000.0);
+		*den = 1000;
+		return 1;
+	}
+	return 0;
+}
+
+/* a * b % m without overflow, for a, b, m < 2^52 */
+static long long mulmod(long long a, long long b, long long m) {
+	long long r = 0;
+	a %= m;
+	b %= m;
+	while (b) {
+		if (b & 1)
+			r = (r + a) % m;
+		a = (a * 2) % m;
+		b >>= 1;
+	}
+	return r;
+}
+
+/* half-bit length sample_rate / (fps * 160) from the fractions, 0 if too large */
+static void set_half_bit(LTCEncoder *e, long long sr_num, long long sr_den, long long fps_num, long long fps_den) {
+	e->half_num = 0;
+	e->half_den = 0;
+	if (sr_num > (1LL << 40) || sr_den > (1LL << 20) || fps_num > (1LL << 20) || fps_den > (1LL << 20))
+		return;
+	long long num = sr_num * fps_den;
+	long long den = sr_den * fps_num * 160;
+	const long long g = gcd(num, den);
+	num /= g;
+	den /= g;
+	if (num > (1LL << 52) || den > (1LL << 52))
+		return;
+	e->half_num = num;
+	e->half_den = den;
+	e->half_remainder = den / 2;
+}
+
 LTCEncoder* ltc_encoder_create(double sample_rate, double fps, enum LTC_TV_STANDARD standard, int flags) {
 	if (sample_rate < 1)
 		return NULL;
@@ -137,9 +335,12 @@ LTCEncoder* ltc_encoder_create(double sample_rate, double fps, enum LTC_TV_STAND
 	/*-3.0 dBFS default */
 	e->enc_lo = 38;
 	e->enc_hi = 218;
+	e->amplitude = pow(10, -3.0/20.0);
+	e->format = LTC_SAMPLE_U8;
+	e->sample_size = sizeof(ltcsnd_sample_t);
 
 	e->bufsize = 1 + ceil(sample_rate / fps);
-	e->buf = (ltcsnd_sample_t*) calloc(e->bufsize, sizeof(ltcsnd_sample_t));
+	e->buf = (ltcsnd_sample_t*) calloc(e->bufsize, e->sample_size);
 	if (!e->buf) {
 		free(e);
 		return NULL;
@@ -175,6 +376,15 @@ int ltc_encoder_reinit(LTCEncoder *e, double sample_rate, double fps, enum LTC_T
 	e->samples_per_clock = sample_rate / (fps * 80.0);
 	e->samples_per_clock_2 = e->samples_per_clock / 2.0;
 	e->sample_remainder = 0.5;
+	encode_reset_position(e);
+
+	long long sr_num, sr_den, fps_num, fps_den;
+	if (rate_ratio(sample_rate, &sr_num, &sr_den) && rate_ratio(fps, &fps_num, &fps_den)) {
+		set_half_bit(e, sr_num, sr_den, fps_num, fps_den);
+	} else {
+		e->half_num = 0;
+		e->half_den = 0;
+	}
 
 	if (flags & LTC_BGF_DONT_TOUCH) {
 		e->f.col_frame = 0;
@@ -202,24 +412,80 @@ int ltc_encoder_reinit(LTCEncoder *e, double sample_rate, double fps, enum LTC_T
 		e->f.dfbit = 1;
 	else
 		e->f.dfbit = 0;
+	encode_prepare_edges(e);
+	return 0;
+}
+
+int ltc_encoder_set_exact_rate(LTCEncoder *e, long long sample_rate_num, long long sample_rate_den, long long fps_num, long long fps_den) {
+	if (sample_rate_num < 1 || sample_rate_den < 1 || fps_num < 1 || fps_den < 1)
+		return -1;
+	if (ltc_encoder_reinit(e, (double) sample_rate_num / sample_rate_den, (double) fps_num / fps_den, e->standard, e->flags))
+		return -1;
+	set_half_bit(e, sample_rate_num, sample_rate_den, fps_num, fps_den);
+	return e->half_den ? 0 : -1;
+}
+
+int ltc_encoder_get_frame_length(LTCEncoder *e, long long *num, long long *den) {
+	if (!e->half_den)
+		return -1;
+	const long long g = gcd(e->half_num * 160, e->half_den);
+	*num = e->half_num * 160 / g;
+	*den = e->half_den / g;
+	return 0;
+}
+
+int ltc_encoder_get_frame_samples(LTCEncoder *e) {
+	if (e->half_den) {
+		/* the remainders of the 160 half-bits telescope */
+		return (int)((e->half_remainder + 160 * e->half_num) / e->half_den);
+	}
+	/* as encode_run_length() would count them */
+	double remainder = e->sample_remainder;
+	int bit, n = 0;
+	for (bit = 0 ; bit < LTC_FRAME_BIT_COUNT ; bit++) {
+		const unsigned char c = ((unsigned char*)&e->f)[bit / 8];
+		const int one = (c >> (bit % 8)) & 1;
+		const double spb = one ? e->samples_per_clock_2 : e->samples_per_clock;
+		int run;
+		for (run = 0 ; run < (one ? 2 : 1) ; run++) {
+			const int k = (int)(spb + remainder);
+			remainder = spb + remainder - k;
+			n += k;
+		}
+	}
+	return n;
+}
+
+int ltc_encoder_set_phase(LTCEncoder *e, long long frames) {
+	if (!e->half_den || frames < 0)
+		return -1;
+	/* the remainder after 160 * frames half-bits, starting at 0.5 */
+	const long long step = mulmod(160, e->half_num, e->half_den);
+	e->half_remainder = (mulmod(frames, step, e->half_den) + e->half_den / 2) % e->half_den;
 	return 0;
 }
 
 void ltc_encoder_reset(LTCEncoder *e) {
 	e->state = 0;
 	e->sample_remainder = 0.5;
+	e->half_remainder = e->half_den / 2;
 	e->offset = 0;
+	encode_reset_position(e);
 }
 
 int ltc_encoder_set_volume(LTCEncoder *e, double dBFS) {
 	if (dBFS > 0)
 		return -1;
 	double pp = rint(127.0 * pow(10, dBFS/20.0));
-	if (pp < 1 || pp > 127)
+	if (e->format == LTC_SAMPLE_U8 && (pp < 1 || pp > 127))
 		return -1;
+	e->amplitude = pow(10, dBFS/20.0);
+	if (pp < 1)
+		pp = 1; /* keep the 8 bit levels at their smallest step */
 	ltcsnd_sample_t diff = ((ltcsnd_sample_t) pp)&0x7f;
 	e->enc_lo = SAMPLE_CENTER - diff;
 	e->enc_hi = SAMPLE_CENTER + diff;
+	encode_prepare_edges(e);
 	return 0;
 }
 
@@ -236,19 +502,40 @@ void ltc_encoder_set_filter(LTCEncoder *e, double rise_time) {
 		e->filter_const = 0;
 	else
 		e->filter_const = 1.0 - exp( -1.0 / (e->sample_rate * rise_time / 2000000.0 / exp(1.0)) );
+	encode_prepare_edges(e);
 }
 
 int ltc_encoder_set_bufsize(LTCEncoder *e, double sample_rate, double fps) {
 	free (e->buf);
 	e->offset = 0;
 	e->bufsize = 1 + ceil(sample_rate / fps);
-	e->buf = (ltcsnd_sample_t*) calloc(e->bufsize, sizeof(ltcsnd_sample_t));
+	e->buf = (ltcsnd_sample_t*) calloc(e->bufsize, e->sample_size);
+	if (!e->buf) {
+		return -1;
+	}
+	return 0;
+}
+
+int ltc_encoder_set_format(LTCEncoder *e, enum LTC_SAMPLE_FORMAT format) {
+	const size_t sample_size = encode_sample_size(format);
+	if (sample_size == 0)
+		return -1;
+	free (e->buf);
+	e->offset = 0;
+	e->format = format;
+	e->sample_size = sample_size;
+	e->buf = (ltcsnd_sample_t*) calloc(e->bufsize, e->sample_size);
 	if (!e->buf) {
 		return -1;
 	}
+	encode_prepare_edges(e);
 	return 0;
 }
 
+enum LTC_SAMPLE_FORMAT ltc_encoder_get_format(LTCEncoder *e) {
+	return e->format;
+}
+
 int ltc_encoder_encode_byte(LTCEncoder *e, int byte, double speed) {
 	return encode_byte(e, byte, speed);
 }
@@ -260,6 +547,16 @@ void ltc_encoder_encode_frame(LTCEncoder *e) {
 	}
 }
 
+int ltc_encoder_encode_samples(LTCEncoder *e, void *buf, int size, int stride) {
+	if (!buf || size <= 0 || stride < 1)
+		return 0;
+	return encode_samples(e, (unsigned char*) buf, size, stride);
+}
+
+int ltc_encoder_get_frame_position(LTCEncoder *e) {
+	return e->frame_pos;
+}
+
 void ltc_encoder_get_timecode(LTCEncoder *e, SMPTETimecode *t) {
 	ltc_frame_to_time(t, &e->f, e->flags);
 }
@@ -340,7 +637,7 @@ ltcsnd_sample_t *ltc_encoder_get_bufptr(LTCEncoder *e, int *size, int flush) {
 
 int ltc_encoder_get_buffer(LTCEncoder *e, ltcsnd_sample_t *buf) {
 	const int len = e->offset;
-	memcpy(buf, e->buf, len * sizeof(ltcsnd_sample_t) );
+	memcpy(buf, e->buf, len * e->sample_size );
 	e->offset = 0;
 	return(len);
 }
@@ -269,6 +269,14 @@ enum LTC_BG_FLAGS {
 	LTC_NO_PARITY = 8 ///< parity bit is left untouched when setting or in/decrementing the encoder frame-number
 };
 
+/** sample format of the encoder output, see \ref ltc_encoder_set_format */
+enum LTC_SAMPLE_FORMAT {
+	LTC_SAMPLE_U8 = 0, ///< ltcsnd_sample_t, 8 bit unsigned with 128 at the center (default)
+	LTC_SAMPLE_FLOAT,  ///< float, -1.0 .. 1.0
+	LTC_SAMPLE_S16,    ///< signed 16 bit (short), -32767 .. 32767
+	LTC_SAMPLE_S32     ///< signed 32 bit (int), -2147483647 .. 2147483647
+};
+
 /**
  * see LTCFrame
  */
@@ -339,6 +347,12 @@ typedef struct LTCDecoder LTCDecoder;
  */
 typedef struct LTCEncoder LTCEncoder;
 
+/**
+ * Opaque structure
+ * see: \ref ltc_batch_decoder_create, \ref ltc_batch_decoder_free
+ */
+typedef struct LTCBatchDecoder LTCBatchDecoder;
+
 /**
  * Convert binary LTCFrame into SMPTETimecode struct
  *
@@ -422,6 +436,16 @@ LTCDecoder * ltc_decoder_create(int apv, int queue_size);
  */
 int ltc_decoder_free(LTCDecoder *d);
 
+/**
+ * Create a decoder with the complete state of another one, including
+ * its queued frames. Feeding the copy the audio that follows continues
+ * the decode exactly where \p d stopped.
+ *
+ * @param d decoder handle
+ * @return new decoder handle, release with \ref ltc_decoder_free, or NULL if out-of-memory
+ */
+LTCDecoder * ltc_decoder_copy(const LTCDecoder *d);
+
 /**
  * Feed the LTC decoder with new audio samples.
  *
@@ -493,6 +517,75 @@ void ltc_decoder_queue_flush(LTCDecoder* d);
  */
 int ltc_decoder_queue_length(LTCDecoder* d);
 
+/**
+ * Create a decoder for several channels that are processed in lockstep.
+ *
+ * From 8 lanes on, envelope and edge tracking runs branch-free on groups
+ * of 16 lanes, which the compiler vectorizes; only lanes with a biphase
+ * state change take the scalar bit parser. Below 8 lanes the padding of a
+ * group costs more than it saves and each lane is decoded by its own
+ * scalar decoder. The decoded frames are identical to running one
+ * \ref LTCDecoder per lane.
+ *
+ * Measured with `ltc_bench batch` (256 sample buffers, 48kHz) against one
+ * \ref LTCDecoder per channel: 0.8-1.1x below 8 lanes, 1.0-1.2x at 8,
+ * 1.5-1.7x at 16 and 1.7-2.1x at 64 lanes. The bit parser stays scalar
+ * and limits the gain.
+ *
+ * @param lanes number of channels
+ * @param apv audio-frames per video frame, see \ref ltc_decoder_create
+ * @param queue_size length of each lane's frame queue
+ * @return decoder handle or NULL if out-of-memory
+ */
+LTCBatchDecoder * ltc_batch_decoder_create(int lanes, int apv, int queue_size);
+
+/**
+ * Release memory of a batch decoder.
+ * @param b decoder handle
+ */
+int ltc_batch_decoder_free(LTCBatchDecoder *b);
+
+/**
+ * Number of lanes of a batch decoder.
+ * @param b decoder handle
+ */
+int ltc_batch_decoder_lanes(LTCBatchDecoder *b);
+
+/**
+ * Feed the batch decoder with interleaved audio.
+ *
+ * @param b decoder handle
+ * @param buf sample of lane 0 of the first audio-frame, lane l is at buf[l]
+ * @param size number of audio-frames to parse
+ * @param stride distance between consecutive audio-frames in samples (>= lanes)
+ * @param posinfo sample-offset in the audio-stream, see \ref ltc_decoder_write
+ */
+void ltc_batch_decoder_write(LTCBatchDecoder *b,
+		ltcsnd_sample_t *buf, size_t size, size_t stride,
+		ltc_off_t posinfo);
+
+/**
+ * Wrapper around \ref ltc_batch_decoder_write that accepts interleaved
+ * floating point audio samples.
+ *
+ * @param b decoder handle
+ * @param buf sample of lane 0 of the first audio-frame
+ * @param size number of audio-frames to parse
+ * @param stride distance between consecutive audio-frames in samples (>= lanes)
+ * @param posinfo sample-offset in the audio-stream.
+ */
+void ltc_batch_decoder_write_float(LTCBatchDecoder *b, float *buf, size_t size, size_t stride, ltc_off_t posinfo);
+
+/**
+ * Retrieve a decoded frame of one lane, see \ref ltc_decoder_read
+ *
+ * @param b decoder handle
+ * @param lane 0 .. lanes - 1
+ * @param frame the decoded LTC frame is copied there
+ * @return 1 on success or 0 when no frames queued.
+ */
+int ltc_batch_decoder_read(LTCBatchDecoder *b, int lane, LTCFrameExt *frame);
+
 
 
 /**
@@ -595,10 +688,13 @@ void ltc_encoder_get_frame(LTCEncoder *e, LTCFrame *f);
  * Copy the accumulated encoded audio to the given
  * sample-buffer and flush the internal buffer.
  *
+ * With an output format other than LTC_SAMPLE_U8 (see
+ * \ref ltc_encoder_set_format) buf is cast to that sample type.
+ *
  * @param e encoder handle
  * @param buf place to store the audio-samples, needs to be large enough
- * to hold \ref ltc_encoder_get_buffersize bytes
- * @return the number of bytes written to the memory area
+ * to hold \ref ltc_encoder_get_buffersize samples
+ * @return the number of samples written to the memory area
  * pointed to by buf.
  */
 int ltc_encoder_get_buffer(LTCEncoder *e, ltcsnd_sample_t *buf);
@@ -607,8 +703,11 @@ int ltc_encoder_get_buffer(LTCEncoder *e, ltcsnd_sample_t *buf);
 /**
  * Retrieve a pointer to the accumulated encoded audio-data.
  *
+ * With an output format other than LTC_SAMPLE_U8 (see
+ * \ref ltc_encoder_set_format) cast the pointer to that sample type.
+ *
  * @param e encoder handle
- * @param size if set, the number of valid bytes in the buffer is stored there
+ * @param size if set, the number of valid samples in the buffer is stored there
  * @param flush call \ref ltc_encoder_buffer_flush - reset the buffer write-pointer
  * @return pointer to encoder-buffer
  */
@@ -649,6 +748,12 @@ size_t ltc_encoder_get_buffersize(LTCEncoder *e);
  * If fps equals to 29.97 or 30000.0/1001.0, the LTCFrame's 'dfbit' bit is set to 1
  * to indicate drop-frame timecode.
  *
+ * Sample rates and fps that are whole numbers, whole thousandths or
+ * n * 1000 / 1001 (23.976, 29.97, 59.94, 47952.048 .., within 2 ppm) are kept
+ * as exact fractions: frame k then starts exactly at sample floor(k * sample_rate / fps + 0.5)
+ * after a reset, without drift however long the encoder runs. Others fall back
+ * to floating point, see \ref ltc_encoder_set_exact_rate.
+ *
  * Unless the LTC_BGF_DONT_TOUCH flag is set the BGF1 is set or cleared depending
  * on LTC_TC_CLOCK and BGF0,2 according to LTC_USE_DATE and the given standard.
  * col_frame is cleared  and the parity recomputed (unless LTC_NO_PARITY is given).
@@ -661,6 +766,58 @@ size_t ltc_encoder_get_buffersize(LTCEncoder *e);
  */
 int ltc_encoder_reinit(LTCEncoder *e, double sample_rate, double fps, enum LTC_TV_STANDARD standard, int flags);
 
+/**
+ * Set the sample rate and fps as the exact fractions
+ * sample_rate_num / sample_rate_den and fps_num / fps_den,
+ * for rates \ref ltc_encoder_reinit doesn't recognize.
+ * Otherwise the same as calling \ref ltc_encoder_reinit with
+ * the standard and flags the encoder has.
+ *
+ * @param e encoder handle
+ * @param sample_rate_num numerator of the audio sample rate (e.g. 48000000)
+ * @param sample_rate_den denominator of the audio sample rate (e.g. 1001)
+ * @param fps_num numerator of the frame rate (e.g. 30000)
+ * @param fps_den denominator of the frame rate (e.g. 1001)
+ * @return 0 on success, -1 if a value is out of range or the buffer is too small
+ */
+int ltc_encoder_set_exact_rate(LTCEncoder *e, long long sample_rate_num, long long sample_rate_den, long long fps_num, long long fps_den);
+
+/**
+ * Query the exact length of a frame in samples.
+ * Frame k after a reset starts at sample floor(k * num / den + 0.5).
+ *
+ * @param e encoder handle
+ * @param num the samples per frame numerator is stored here
+ * @param den the samples per frame denominator is stored here
+ * @return 0 on success, -1 if the encoder has no exact rate
+ */
+int ltc_encoder_get_frame_length(LTCEncoder *e, long long *num, long long *den);
+
+/**
+ * Query how many samples \ref ltc_encoder_encode_samples writes for the
+ * current frame. With an exact rate this varies by a sample from frame to
+ * frame, see \ref ltc_encoder_get_frame_length.
+ * Call at a frame boundary, see \ref ltc_encoder_get_frame_position.
+ *
+ * @param e encoder handle
+ * @return the length of the current frame in samples
+ */
+int ltc_encoder_get_frame_samples(LTCEncoder *e);
+
+/**
+ * Encode the following frames as long as frames 'frames', 'frames' + 1 ..
+ * of a stream that started with a reset. Called at sample
+ * floor(frames * num / den + 0.5) of a timeline, frame 'frames' + k
+ * then starts at sample floor((frames + k) * num / den + 0.5) of it,
+ * see \ref ltc_encoder_get_frame_length.
+ * Call at a frame boundary, e.g. right after \ref ltc_encoder_reset.
+ *
+ * @param e encoder handle
+ * @param frames the frame of the reference stream encoded next, >= 0
+ * @return 0 on success, -1 if the encoder has no exact rate
+ */
+int ltc_encoder_set_phase(LTCEncoder *e, long long frames);
+
 /**
  * reset ecoder state.
  * flushes buffer, reset biphase state
@@ -694,18 +851,47 @@ int ltc_encoder_set_bufsize(LTCEncoder *e, double sample_rate, double fps);
  * typically LTC is sent at 0dBu ; in EBU callibrated systems that
  * corresponds to -18dBFS. - by default libltc creates -3dBFS
  *
- * since libltc generated 8bit audio-data, the minimum dBFS
+ * with 8bit audio-data (LTC_SAMPLE_U8), the minimum dBFS
  * is about -42dB which corresponds to 1 bit.
  *
  * 0dB corresponds to a signal range of 127
  * 1..255 with 128 at the center.
  *
+ * The float, s16 and s32 output formats use the given
+ * level as is, without rounding it to the 8 bit steps.
+ *
  * @param e encoder handle
  * @param dBFS the volume in dB full-scale (<= 0.0)
  * @return 0 on success, -1 if the value was out of range
  */
 int ltc_encoder_set_volume(LTCEncoder *e, double dBFS);
 
+/**
+ * Select the sample format of the generated audio.
+ *
+ * The encoder writes float, signed 16 bit or signed 32 bit samples
+ * directly into its internal buffer, without an 8 bit intermediate.
+ * They are centered at 0 and filtered like the 8 bit output
+ * (see \ref ltc_encoder_set_filter), the level is the one
+ * given to \ref ltc_encoder_set_volume.
+ *
+ * This re-allocates the internal buffer (not realtime safe) and
+ * flushes it, alike \ref ltc_encoder_set_bufsize.
+ *
+ * @param e encoder handle
+ * @param format the sample format, default LTC_SAMPLE_U8
+ * @return 0 on success, -1 if the format is invalid or allocation fails
+ */
+int ltc_encoder_set_format(LTCEncoder *e, enum LTC_SAMPLE_FORMAT format);
+
+/**
+ * Query the sample format of the generated audio.
+ *
+ * @param e encoder handle
+ * @return the format set with \ref ltc_encoder_set_format
+ */
+enum LTC_SAMPLE_FORMAT ltc_encoder_get_format(LTCEncoder *e);
+
 /**
  * Set encoder signal rise-time / signal filtering
  *
@@ -763,6 +949,44 @@ int ltc_encoder_encode_byte(LTCEncoder *e, int byte, double speed);
  */
 void ltc_encoder_encode_frame(LTCEncoder *e);
 
+/**
+ * Encode the current LTC frame at fixed speed directly into
+ * a caller-supplied buffer, a part of it at a time.
+ *
+ * Each call continues exactly where the previous one stopped
+ * (bit, half-bit and fractional sample position), so audio
+ * buffers of any size can be filled without an intermediate buffer.
+ * The output is the same as that of \ref ltc_encoder_encode_frame.
+ *
+ * Encoding stops at the end of the frame: fewer than size samples
+ * are written when it ends within the buffer. Set the next frame (e.g.
+ * \ref ltc_encoder_inc_timecode or \ref ltc_encoder_set_frame) and call
+ * again for the rest. The frame must not be changed while it is being
+ * encoded, see \ref ltc_encoder_get_frame_position.
+ *
+ * The internal buffer is not used; don't mix this with
+ * \ref ltc_encoder_encode_byte in the middle of a frame.
+ * \ref ltc_encoder_reset and \ref ltc_encoder_reinit restart the frame.
+ *
+ * @param e encoder handle
+ * @param buf where to write the samples, in the format set with
+ * \ref ltc_encoder_set_format
+ * @param size maximum number of samples to write
+ * @param stride distance between consecutive samples in buf, in samples
+ * (e.g. the number of channels of interleaved audio), >= 1
+ * @return the number of samples written
+ */
+int ltc_encoder_encode_samples(LTCEncoder *e, void *buf, int size, int stride);
+
+/**
+ * Query how far \ref ltc_encoder_encode_samples is into the current frame.
+ *
+ * @param e encoder handle
+ * @return the number of samples of the current frame written so far,
+ * 0 if the next sample starts a new frame
+ */
+int ltc_encoder_get_frame_position(LTCEncoder *e);
+
 /**
  * Set the parity of the LTC frame.
  *
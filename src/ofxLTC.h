@@ -13,12 +13,42 @@
 #include "ofSoundStream.h"
 #include "ofSoundBuffer.h"
 #include "ofUtils.h"
-#include "ofThread.h"
 #include "ofLog.h"
 
+#include "ofxLTC/Clock.h"
+#include "ofxLTC/EncoderStream.h"
+#include "ofxLTC/Generator.h"
+#include "ofxLTC/Latency.h"
+#include "ofxLTC/RenderAhead.h"
+#include "ofxLTC/SampleClock.h"
+#include "ofxLTC/SeqLock.h"
+#include "ofxLTC/TimecodeSnapshot.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
 
 namespace ofx {
     namespace LTC {
+        enum class LockState {
+            Locked,    // real frames are being decoded
+            Freewheel, // signal lost, frames are extrapolated at the measured rate
+            Lost,      // no signal and the flywheel ran out
+        };
+        
+        inline const char *toString(LockState state) {
+            switch(state) {
+                case LockState::Locked: return "LOCKED";
+                case LockState::Freewheel: return "FREEWHEEL";
+                case LockState::Lost: return "LOST";
+            }
+            return "";
+        }
+        
         struct Timecode {
             LTCFrameExt raw_data;
             std::string timezone;
@@ -30,6 +60,7 @@ namespace ofx {
             std::uint8_t sec;
             std::uint8_t frame;
             bool reverse;
+            bool extrapolated{false}; // predicted by the flywheel, not decoded
             
             std::string toString() const {
                 return ofVAArgsToString("%04d/%02d/%02d[%s] %02d:%02d:%02d%c%02d",
@@ -39,8 +70,71 @@ namespace ofx {
                                         frame);
             }
             
-            float receivedTime;
+            float receivedTime; // ofGetElapsedTimef() domain, derived from monotonicTime
+            std::int64_t samplePosition{0}; // stream sample where the frame ended (off_end)
+            double monotonicTime{0.0}; // getMonotonicTime() at samplePosition
         };
+        // Timecode fields from a decoded frame, without timing
+        inline Timecode makeTimecode(const LTCFrameExt &frame) {
+            Timecode timecode;
+            std::memcpy(&timecode.raw_data, &frame, sizeof(frame));
+            SMPTETimecode stime;
+            ltc_frame_to_time(&stime, &timecode.raw_data.ltc, LTC_USE_DATE);
+            
+            timecode.timezone = stime.timezone;
+            timecode.year = (stime.years < 67)
+                          ? (2000 + stime.years)
+                          : (1900 + stime.years);
+            timecode.month = stime.months;
+            timecode.day = stime.days;
+            timecode.hour = stime.hours;
+            timecode.min = stime.mins;
+            timecode.sec = stime.secs;
+            timecode.frame = stime.frame;
+            timecode.reverse = frame.reverse;
+            timecode.samplePosition = frame.off_end;
+            return timecode;
+        }
+        
+        inline TimecodeSnapshot makeSnapshot(const Timecode &timecode) {
+            TimecodeSnapshot snapshot;
+            std::memset(&snapshot, 0, sizeof(snapshot));
+            snapshot.raw_data = timecode.raw_data;
+            snapshot.setTimezone(timecode.timezone.c_str());
+            snapshot.year = timecode.year;
+            snapshot.month = timecode.month;
+            snapshot.day = timecode.day;
+            snapshot.hour = timecode.hour;
+            snapshot.min = timecode.min;
+            snapshot.sec = timecode.sec;
+            snapshot.frame = timecode.frame;
+            snapshot.reverse = timecode.reverse;
+            snapshot.extrapolated = timecode.extrapolated;
+            snapshot.receivedTime = timecode.receivedTime;
+            snapshot.samplePosition = timecode.samplePosition;
+            snapshot.monotonicTime = timecode.monotonicTime;
+            return snapshot;
+        }
+        
+        inline Timecode makeTimecode(const TimecodeSnapshot &snapshot) {
+            Timecode timecode;
+            timecode.raw_data = snapshot.raw_data;
+            timecode.timezone = snapshot.timezone;
+            timecode.year = snapshot.year;
+            timecode.month = snapshot.month;
+            timecode.day = snapshot.day;
+            timecode.hour = snapshot.hour;
+            timecode.min = snapshot.min;
+            timecode.sec = snapshot.sec;
+            timecode.frame = snapshot.frame;
+            timecode.reverse = snapshot.reverse;
+            timecode.extrapolated = snapshot.extrapolated;
+            timecode.receivedTime = snapshot.receivedTime;
+            timecode.samplePosition = snapshot.samplePosition;
+            timecode.monotonicTime = snapshot.monotonicTime;
+            return timecode;
+        }
+        
         struct Receiver {
             ~Receiver() {
                 ltc_decoder_free(decoder);
@@ -51,48 +145,195 @@ namespace ofx {
                        std::size_t channel_offset = 0ul) {
                 ofSoundStreamSettings settings_ = settings;
                 settings_.setInListener(this);
-                this->channel_offset = channel_offset;
+                setupDecoder(settings_.sampleRate, channel_offset);
+                if(settings_.getInDevice()) {
+                    setInputLatency(getDeviceLatency(settings_.getInDevice()->name).input);
+                }
                 soundStream.setup(settings_);
-                
+            }
+            
+            // decoder only, without opening a sound stream. feed audioIn yourself.
+            void setupDecoder(double sample_rate,
+                              std::size_t channel_offset = 0ul) {
+                this->channel_offset = channel_offset;
+                this->sample_rate = sample_rate;
+                if(decoder) ltc_decoder_free(decoder);
                 decoder = ltc_decoder_create(1920, 32);
-                total = 0ul;
+                total = 0;
+                sample_clock.reset(sample_rate);
             }
             
+            // time from the signal at the input jack to audioIn.
+            // subtracted from every reported time.
+            void setInputLatency(double seconds)
+            { sample_clock.latency = -seconds; };
+            
+            double getInputLatency() const
+            { return -sample_clock.latency; };
+            
             void onReceive(const std::function<void(Timecode)> &callback)
             { this->callback = callback; };
             
+            const std::function<void(Timecode)> &getOnReceive() const
+            { return callback; };
+            
+            void onLockStateChange(const std::function<void(LockState, LockState)> &callback)
+            { this->state_callback = callback; };
+            
+            // the decoded frame as is, with its getMonotonicTime() at off_end.
+            // called on the audio thread right before onReceive, e.g. for a CaptureLogWriter.
+            void onFrame(const std::function<void(const LTCFrameExt &, bool, double)> &callback)
+            { this->frame_callback = callback; };
+            
+            // every buffer as (stream position, sample frames, arrival) before it is decoded
+            void onBuffer(const std::function<void(std::int64_t, std::size_t, double)> &callback)
+            { this->buffer_callback = callback; };
+            
+            // keep delivering extrapolated frames for up to `frames` frames
+            // after the signal drops out. 0 disables the flywheel.
+            void setFlywheelFrames(std::size_t frames)
+            { flywheel_frames = frames; };
+            
+            std::size_t getFlywheelFrames() const
+            { return flywheel_frames; };
+            
+            LockState getLockState() const
+            { return lock_state.load(); };
+            
+            // interpolated timecode as fractional frames since 00:00:00:00 at the
+            // given getMonotonicTime() instant. lock-free, callable from any thread.
+            // negative until the receiver has locked.
+            double timeAt(double monotonic_time) const
+            { return clock.timeAt(monotonic_time); };
+            
+            double timeAt() const
+            { return timeAt(getMonotonicTime()); };
+            
+            const Clock &getClock() const
+            { return clock; };
+            
+            double getSampleRate() const
+            { return sample_rate; };
+            
+            // integer frame rate measured from the signal, 0 until known
+            int getFps() const
+            { return 0.0 < frame_period ? estimatedFps() : 0; };
+            
             std::vector<ofSoundDevice> getDeivceList() const
             { return soundStream.getDeviceList(); };
             
             void audioIn(ofSoundBuffer &buffer) {
-                std::vector<std::uint8_t> buf;
+                process(buffer, total, getMonotonicTime());
+            }
+            
+            // decode one buffer that starts at stream sample `position` and
+            // whose callback fired at monotonic time `arrival`.
+            // lets several receivers share one stream and one sample clock (see StreamHub).
+            void process(const ofSoundBuffer &buffer, std::int64_t position, double arrival) {
+                total = position;
                 getBytePCM(buffer, buf);
+                buffer_callback(total, buf.size(), arrival);
+                sample_clock.update(arrival, total + static_cast<std::int64_t>(buf.size()));
                 ltc_decoder_write(decoder, buf.data(), buf.size(), total);
                 while(ltc_decoder_read(decoder, &frame)) {
-                    Timecode timecode;
-                    std::memcpy(&timecode.raw_data, &frame, sizeof(frame));
-                    SMPTETimecode stime;
-                    ltc_frame_to_time(&stime, &frame.ltc, LTC_USE_DATE);
-                    
-                    timecode.timezone = stime.timezone;
-                    timecode.year = (stime.years < 67)
-                                  ? (2000 + stime.years)
-                                  : (1900 + stime.years);
-                    timecode.month = stime.months;
-                    timecode.day = stime.days;
-                    timecode.hour = stime.hours;
-                    timecode.min = stime.mins;
-                    timecode.sec = stime.secs;
-                    timecode.frame = stime.frame;
-                    timecode.reverse = frame.reverse;
-                    timecode.receivedTime = ofGetElapsedTimef();
-                    callback(timecode);
+                    // the last frame before a dropout is only completed by the next edge,
+                    // drop it if the flywheel already stood in for it.
+                    if(frame.off_start <= extrapolated_until) continue;
+                    resync(frame);
+                    deliver(frame, false);
                 }
                 total += buf.size();
+                freewheel(total);
             }
 
         protected:
-
+            Timecode toTimecode(const LTCFrameExt &frame, bool extrapolated) const {
+                Timecode timecode = makeTimecode(frame);
+                timecode.extrapolated = extrapolated;
+                timecode.monotonicTime = sampleTime(frame.off_end);
+                timecode.receivedTime = ofGetElapsedTimef() - static_cast<float>(getMonotonicTime() - timecode.monotonicTime);
+                return timecode;
+            }
+            
+            double sampleTime(std::int64_t position) const
+            { return sample_clock.timeOf(position); };
+            
+            void deliver(const LTCFrameExt &frame, bool extrapolated) {
+                frame_callback(frame, extrapolated, sampleTime(frame.off_end));
+                callback(toTimecode(frame, extrapolated));
+            }
+            
+            void setLockState(LockState state) {
+                LockState previous = lock_state.exchange(state);
+                if(previous != state) state_callback(previous, state);
+            }
+            
+            // a real frame arrived: measure the frame period and re-sync the flywheel to it
+            void resync(const LTCFrameExt &frame) {
+                if(has_last && !last_extrapolated) {
+                    const double period = static_cast<double>(frame.off_start - last_frame.off_start);
+                    // ignore jumps and gaps, only consecutive frames tell the rate
+                    if(frame_period <= 0.0) {
+                        if(0.0 < period) frame_period = period;
+                    } else if(frame_period * 0.5 < period && period < frame_period * 1.5) {
+                        frame_period += (period - frame_period) * 0.25;
+                    }
+                }
+                if(0.0 < frame_period) {
+                    const int fps = estimatedFps();
+                    // a reversed frame reaches its own position at off_end
+                    const auto position = frame.reverse ? frame.off_end : frame.off_start;
+                    clock.update(toFrameCount(frame.ltc, fps), sampleTime(position),
+                                 fps, frame.ltc.dfbit != 0, frame.reverse != 0);
+                }
+                last_frame = frame;
+                has_last = true;
+                last_extrapolated = false;
+                predicted_start = static_cast<double>(frame.off_start);
+                predicted_end = static_cast<double>(frame.off_end);
+                freewheel_count = 0;
+                setLockState(LockState::Locked);
+            }
+            
+            // called after each buffer. once a frame is overdue by half a period
+            // either extrapolate it or declare the signal lost.
+            void freewheel(std::int64_t position) {
+                if(!has_last || frame_period <= 0.0 || lock_state.load() == LockState::Lost) return;
+                
+                while(predicted_end + frame_period * 1.5 < static_cast<double>(position)) {
+                    if(flywheel_frames <= freewheel_count) {
+                        clock.hold(sampleTime(position));
+                        setLockState(LockState::Lost);
+                        has_last = false;
+                        return;
+                    }
+                    
+                    const int fps = estimatedFps();
+                    const auto standard = (fps == 25) ? LTC_TV_625_50 : LTC_TV_525_60;
+                    if(last_frame.reverse) {
+                        ltc_frame_decrement(&last_frame.ltc, fps, standard, LTC_USE_DATE);
+                    } else {
+                        ltc_frame_increment(&last_frame.ltc, fps, standard, LTC_USE_DATE);
+                    }
+                    predicted_start += frame_period;
+                    predicted_end += frame_period;
+                    last_frame.off_start = static_cast<ltc_off_t>(predicted_start);
+                    last_frame.off_end = static_cast<ltc_off_t>(predicted_end);
+                    last_extrapolated = true;
+                    extrapolated_until = last_frame.off_start;
+                    ++freewheel_count;
+                    
+                    setLockState(LockState::Freewheel);
+                    deliver(last_frame, true);
+                }
+            }
+            
+            int estimatedFps() const {
+                if(last_frame.ltc.dfbit) return 30;
+                const int fps = static_cast<int>(std::round(sample_rate / frame_period));
+                return std::max(1, fps);
+            }
+            
             void getBytePCM(const ofSoundBuffer &buffer,
                             std::vector<std::uint8_t> &buf) const
             {
@@ -104,97 +345,224 @@ namespace ofx {
             }
             
             ofSoundStream soundStream;
-            LTCDecoder *decoder;
+            std::vector<std::uint8_t> buf; // one channel as 8 bit, reused across callbacks
+            LTCDecoder *decoder{nullptr};
             LTCFrameExt frame;
             std::size_t channel_offset;
-            std::size_t total;
+            std::int64_t total{0}; // stream position in samples
+            double sample_rate{48000.0};
+            SampleClock sample_clock;
             std::function<void(Timecode)> callback{[](Timecode) {}};
+            std::function<void(LockState, LockState)> state_callback{[](LockState, LockState) {}};
+            std::function<void(const LTCFrameExt &, bool, double)> frame_callback{[](const LTCFrameExt &, bool, double) {}};
+            std::function<void(std::int64_t, std::size_t, double)> buffer_callback{[](std::int64_t, std::size_t, double) {}};
+            
+            std::atomic<LockState> lock_state{LockState::Lost};
+            std::size_t flywheel_frames{0ul};
+            std::size_t freewheel_count{0ul};
+            LTCFrameExt last_frame;
+            bool has_last{false};
+            bool last_extrapolated{false};
+            double frame_period{0.0}; // measured samples per frame
+            double predicted_start{0.0};
+            double predicted_end{0.0};
+            ltc_off_t extrapolated_until{-1};
+            Clock clock;
         };
     
-        class Sender  : public ofThread, public ofBaseSoundOutput {
+        // the transport runs on the samples audioOut consumes: while playing,
+        // every frame encoded is one frame on from the last, while stopped the
+        // last one repeats. there is no timer thread.
+        // the encoding side owns the timecode; setTimecode hands it a copy and
+        // the audio thread publishes every frame it sends, so getTimecode and
+        // setTimecode never touch what is being encoded.
+        class Sender  : public ofBaseSoundOutput {
         public:
+            // what audioOut does with the buffer besides the LTC channels
+            enum class OutputMode {
+                Replace, // silences the other channels
+                Mix // adds the LTC, leaves the other channels as they are
+            };
+
             Sender() {
                 setTimecode(0, 0, 0, 0);
             }
             virtual ~Sender() {
-                if (encoder) {
-                    ltc_encoder_free(encoder);
-                    encoder = nullptr;
-                    waitForThread();
-                }
+                // no more audioOut before the encoder goes
+                soundStream.close();
+                stopRenderAhead();
             }
             
+            // from the next frame on, the timecode moves on by one every frame.
+            // after setTimecode the first frame sent is that timecode.
             void start()
             {
-                if (!encoder) return;
-
-                if (!is_playing && pause_elapsed_time > 0) {
-                    // resume
-                    long paused_duration = ofGetElapsedTimeMillis() - pause_elapsed_time;
-                    playback_start_elapsed_time += paused_duration;
-                    pause_elapsed_time = 0;
-
-                    is_playing = true;
-                    ofLogNotice() << "[LTC] Resumed playback.";
-                    return;
-                }
-
-                playback_start_elapsed_time = ofGetElapsedTimeMillis();
-
-                startTimecode = currentTimecode;
-                frames_already_advanced = 0;
+                if (!stream.isSetup() || is_playing) return;
                 is_playing = true;
-
+                render_ring.requestRestart();
                 ofLogNotice() << "[LTC] Starting playback.";
             }
 
+            // from the next frame on, the current frame repeats
             void stop()
             {
-                if (is_playing) {
-                    pause_elapsed_time = ofGetElapsedTimeMillis();
-                    is_playing = false;
-                }
+                if (!is_playing) return;
+                is_playing = false;
+                render_ring.requestRestart();
             }
 
-            bool isPlaying()
+            bool isPlaying() const
             {
                 return is_playing;
             }
+
+            float getFps() const
+            {
+                return fps;
+            }
+
+            int getSampleRate() const
+            {
+                return sampleRate;
+            }
             void setup(const ofSoundStreamSettings &settings,
                        float fps_, bool drop_frame_ = false,
                        std::size_t channel_offset_ = 0ul,
                        enum LTC_TV_STANDARD standard_ = LTC_TV_525_60,
                        int ltc_flags_ = LTC_USE_DATE)
             {
-                fps = fps_;
-                currentTimecode.raw_data.ltc.dfbit = (int)drop_frame_;
-                channel_offset = channel_offset_;
-                
                 ofSoundStreamSettings settings_ = settings;
                 settings_.setOutListener(this);
 
-                sampleRate = settings_.sampleRate;
-                samplesPerFrame = static_cast<int>(ceil(sampleRate / fps));
+                setupEncoder(settings_.sampleRate, fps_, drop_frame_, channel_offset_, standard_, ltc_flags_);
+                // a callback of the stream's size is mixed in one go
+                if (mix_buffer.size() < settings_.bufferSize) mix_buffer.resize(settings_.bufferSize);
+                if (settings_.getOutDevice()) {
+                    setOutputLatency(getDeviceLatency(settings_.getOutDevice()->name).output);
+                }
 
-                encoder = ltc_encoder_create(
-                    static_cast<double>(sampleRate),
-                    static_cast<double>(fps),
-                    standard_,
-                    ltc_flags_
-                );
+                soundStream.setup(settings_);
+            }
 
-                if (!encoder) {
+            // encoder only, without opening a sound stream. call audioOut yourself.
+            void setupEncoder(int sample_rate_, float fps_, bool drop_frame_ = false,
+                              std::size_t channel_offset_ = 0ul,
+                              enum LTC_TV_STANDARD standard_ = LTC_TV_525_60,
+                              int ltc_flags_ = LTC_USE_DATE)
+            {
+                fps = fps_;
+                // the first frame sent: the timecode so far, in the new drop-frame mode
+                Timecode timecode = getTimecode();
+                timecode.raw_data.ltc.dfbit = drop_frame_ ? 1 : 0;
+                setTimecode(timecode);
+                channel_offset = channel_offset_;
+                output_mask = channel_offset_ < 64 ? std::uint64_t(1) << channel_offset_ : 0;
+
+                sampleRate = sample_rate_;
+                sample_clock.reset(sampleRate);
+                position = 0;
+                // allocated here, audioOut mixes larger buffers in blocks of it
+                mix_buffer.assign(mix_block_size, 0.0f);
+
+                const std::size_t ahead_frames = render_ahead_frames;
+                stopRenderAhead();
+                // float samples straight from the encoder, no 8 bit round trip
+                if (!stream.setup(static_cast<double>(sampleRate), static_cast<double>(fps), standard_, ltc_flags_)) {
                     ofLogError() << "Failed to create LTC encoder";
+                    return;
                 }
+                if (ahead_frames) setRenderAhead(ahead_frames);
+            }
+            
+            // level of the signal in dBFS (<= 0), -3 by default.
+            // applied by the thread that encodes, from its next samples on.
+            void setVolume(double dBFS)
+            {
+                stream.setVolume(dBFS);
+            }
+            
+            double getVolume() const
+            {
+                return stream.getVolume();
+            }
 
-                soundStream.setup(settings_);
-                if (!isThreadRunning()) {
-                    startThread();
-                }
+            // the output channels that carry the LTC, bit c for channel c.
+            // setup / setupEncoder reset it to channel_offset alone.
+            // the signal is encoded once and copied to every channel in mask.
+            // Mix is for program audio written to the buffer before audioOut.
+            void setOutputChannels(std::uint64_t mask, OutputMode mode = OutputMode::Replace)
+            {
+                output_mask = mask;
+                output_mode = mode;
+            }
+
+            std::uint64_t getOutputChannels() const
+            {
+                return output_mask;
+            }
+
+            OutputMode getOutputMode() const
+            {
+                return output_mode;
+            }
+
+            // time from audioOut to the signal at the output jack.
+            // onSend reports the time each frame leaves the device with it.
+            void setOutputLatency(double seconds)
+            {
+                sample_clock.latency = seconds;
             }
 
+            double getOutputLatency() const
+            {
+                return sample_clock.latency;
+            }
+
+            // render-ahead mode: a worker thread keeps `frames` frames of samples
+            // encoded in advance and audioOut only copies them, so no callback pays
+            // for encoding. transport changes (start, stop, setTimecode) take effect
+            // at the next frame start, as when encoding in audioOut. 0 encodes in
+            // audioOut (default).
+            // call after setupEncoder / setup and not while audioOut is running.
+            void setRenderAhead(std::size_t frames)
+            {
+                stopRenderAhead();
+                render_ahead_frames = frames;
+                if (!frames || !stream.isSetup()) return;
+                render_ring.allocate(static_cast<std::size_t>(std::ceil(frames * sampleRate / fps)));
+                render_running = true;
+                render_thread = std::thread([this] { renderAhead(); });
+            }
+
+            std::size_t getRenderAhead() const
+            {
+                return render_ahead_frames;
+            }
+
+            // samples of silence audioOut sent because the worker fell behind
+            std::uint64_t getRenderAheadUnderruns() const
+            {
+                return render_ring.getUnderruns();
+            }
+
+            // called from the audio thread whenever a frame starts being sent.
+            // samplePosition / monotonicTime refer to the frame's first sample.
+            void onSend(const std::function<void(Timecode)> &callback)
+            {
+                sendCallback = callback;
+            }
+
+            const std::function<void(Timecode)> &getOnSend() const
+            {
+                return sendCallback;
+            }
+
+            // the next frame sent, playing or not. from one thread at a time,
+            // taken up when the next frame starts.
             void setTimecode(const Timecode &tc) {
-                currentTimecode = tc;
+                located_timecode.store(makeSnapshot(tc));
+                locate_request.fetch_add(1, std::memory_order_release);
+                render_ring.requestRestart();
             }
 
             void setTimecode(int hour_, int min_, int sec_, int frame_, int year_ = 0, int month_ = 0, int day_ = 0, std::string timezone_ = "+0900", bool drop_frame_ = false, bool reverse = false) {
@@ -210,23 +578,96 @@ namespace ofx {
                 {
                     day_ = ofGetDay();
                 }
-                currentTimecode.year = year_;
-                currentTimecode.month = month_;
-                currentTimecode.day = day_;
-                currentTimecode.hour = hour_;
-                currentTimecode.min = min_;
-                currentTimecode.sec = sec_;
-                currentTimecode.frame = frame_;
-                currentTimecode.timezone = timezone_;
-                currentTimecode.raw_data.ltc.dfbit = (int)drop_frame_;
-                currentTimecode.reverse = reverse;
+                Timecode timecode = getTimecode();
+                timecode.year = year_;
+                timecode.month = month_;
+                timecode.day = day_;
+                timecode.hour = hour_;
+                timecode.min = min_;
+                timecode.sec = sec_;
+                timecode.frame = frame_;
+                timecode.timezone = timezone_;
+                timecode.raw_data.ltc.dfbit = (int)drop_frame_;
+                timecode.reverse = reverse;
+                setTimecode(timecode);
             }
             
+            // from any thread, never blocks the audio thread: the timecode
+            // given to setTimecode until it is sent, then the frame audioOut
+            // last started to send
             Timecode getTimecode() const
             {
-                return currentTimecode;
+                return makeTimecode(getSnapshot());
             }
             
+            TimecodeSnapshot getSnapshot() const
+            {
+                const std::uint32_t request = locate_request.load(std::memory_order_acquire);
+                if (request != sent_locate.load(std::memory_order_acquire)) return located_timecode.load();
+                return sent.load();
+            }
+            
+            void audioOut(ofSoundBuffer &buffer) {
+                sample_clock.update(getMonotonicTime(), position);
+
+                const int num_channels = buffer.getNumChannels();
+                const int num_frames = buffer.getNumFrames();
+                float *out = buffer.getBuffer().data();
+                const std::uint64_t mask = output_mask & (num_channels < 64 ? (std::uint64_t(1) << num_channels) - 1 : ~std::uint64_t(0));
+                const bool mix = output_mode == OutputMode::Mix;
+
+                // encoded once: straight into the first LTC channel, or aside to be mixed in
+                int first = 0;
+                while (first < num_channels && !(mask >> first & 1)) ++first;
+                if (!mix && first < num_channels) {
+                    renderLtc(out + first, num_frames, num_channels, position);
+                } else if (!mix_buffer.empty()) {
+                    // aside in blocks of mix_buffer, the audio thread never allocates
+                    const int block = static_cast<int>(mix_buffer.size());
+                    for (int done = 0; done < num_frames; done += block) {
+                        const int n = std::min(block, num_frames - done);
+                        renderLtc(mix_buffer.data(), n, 1, position + done);
+                        if (!mix) continue;
+                        for (int c = first; c < num_channels; ++c) {
+                            if (!(mask >> c & 1)) continue;
+                            float *channel = out + done * num_channels + c;
+                            for (int j = 0; j < n; ++j) channel[j * num_channels] += mix_buffer[j];
+                        }
+                    }
+                }
+
+                for (int c = 0; c < num_channels && !mix; ++c) {
+                    float *channel = out + c;
+                    if (mask >> c & 1) {
+                        if (c == first) continue;
+                        for (int j = 0; j < num_frames; ++j) channel[j * num_channels] = out[j * num_channels + first];
+                    } else {
+                        for (int j = 0; j < num_frames; ++j) channel[j * num_channels] = 0.0f;
+                    }
+                }
+                position += num_frames;
+            }
+
+            bool isLeapYear(int year) {
+                return ((year % 4 == 0) && (year % 100 != 0)) || (year % 400 == 0);
+            }
+
+            int daysInMonth(int year, int month) {
+                static const int daysPerMonth[12] = {
+                    31, 28, 31, 30, 31, 30,
+                    31, 31, 30, 31, 30, 31
+                };
+
+                if (month == 2) {
+                    return isLeapYear(year) ? 29 : 28;
+                } else if (month >= 1 && month <= 12) {
+                    return daysPerMonth[month - 1];
+                } else {
+                    return 30; // fallback
+                }
+            }
+        protected:
+            // one frame on, skipping the labels drop-frame timecode leaves out
             void updateTimecode()
             {
                 currentTimecode.frame++;
@@ -256,35 +697,55 @@ namespace ofx {
                         }
                     }
                 }
+                // drop-frame labels skip frames 0 and 1 of most minutes
+                if (currentTimecode.raw_data.ltc.dfbit && std::lrint(fps) == 30
+                    && currentTimecode.sec == 0 && currentTimecode.frame == 0 && currentTimecode.min % 10 != 0) {
+                    currentTimecode.frame = 2;
+                }
             }
             
-            void audioOut(ofSoundBuffer &buffer) {
-                static int samples_left_in_frame = 0;
-
-                const int samples_per_frame = encoder->sample_rate / fps;
-                const int num_channels = buffer.getNumChannels();
-
-                for (size_t i = 0; i < buffer.getNumFrames(); ++i) {
-                    if (samples_left_in_frame <= 0) {
-                        // 次のフレームへ進める
-                        generateNextFrame(); // 1フレーム分のLTCエンコードを準備
-
-                        samples_left_in_frame = samples_per_frame;
-                    }
-
-                    // エンコード済みのLTCサンプルを取得
-                    int offset = samples_per_frame - samples_left_in_frame;
-                    ltcsnd_sample_t sample = frameBuffer[offset];
-                    float val = (float(sample) - 128.f) / 127.f;
-
-                    buffer[i * num_channels + 0] = val;
-                    if (num_channels > 1) buffer[i * num_channels + 1] = 0.0f;
+            // a frame handed from the encoding side to the audio thread
+            struct SentFrame {
+                TimecodeSnapshot timecode;
+                std::uint32_t locate; // the setTimecode it follows, see locate_request
+                int length; // samples
+                long long index; // frames since the render-ahead worker restarted the encoder
+            };
+            
+            // the frame generateNextFrame set up
+            SentFrame frameToSend() {
+                SentFrame frame;
+                frame.timecode = makeSnapshot(currentTimecode);
+                frame.timecode.raw_data.ltc = stream.getFrame();
+                frame.locate = applied_locate;
+                frame.length = stream.getFrameSamples();
+                frame.index = 0;
+                return frame;
+            }
 
-                    samples_left_in_frame--;
-                }
+            // audio thread: a frame starts being sent
+            void notifySend(std::int64_t frame_start, const SentFrame &frame) {
+                TimecodeSnapshot snapshot = frame.timecode;
+                snapshot.raw_data.off_start = frame_start;
+                snapshot.raw_data.off_end = frame_start + frame.length - 1;
+                snapshot.samplePosition = frame_start;
+                snapshot.monotonicTime = sample_clock.timeOf(frame_start);
+                sent.store(snapshot);
+                sent_locate.store(frame.locate, std::memory_order_release);
+                sendCallback(makeTimecode(snapshot));
             }
             
+            // sets the frame about to be encoded: the timecode given to setTimecode,
+            // or one frame on from the last while playing. one frame on from the
+            // last is an increment, only a locate converts in full.
             void generateNextFrame() {
+                const std::uint32_t request = locate_request.load(std::memory_order_acquire);
+                if (request != applied_locate) {
+                    applied_locate = request;
+                    currentTimecode = makeTimecode(located_timecode.load());
+                } else if (is_playing) {
+                    updateTimecode();
+                }
                 SMPTETimecode smpte;
                 memset(&smpte, 0, sizeof(smpte));
                 smpte.hours = currentTimecode.hour;
@@ -292,97 +753,119 @@ namespace ofx {
                 smpte.secs = currentTimecode.sec;
                 smpte.frame = currentTimecode.frame;
 
-                if (encoder->flags & LTC_USE_DATE) {
+                if (stream.getFlags() & LTC_USE_DATE) {
                     strncpy(smpte.timezone, currentTimecode.timezone.c_str(), 6);
                     smpte.years = currentTimecode.year % 100;
                     smpte.months = currentTimecode.month;
                     smpte.days = currentTimecode.day;
                 }
 
-                ltc_encoder_set_timecode(encoder, &smpte);
-                LTCFrame frame;
-                ltc_encoder_get_frame(encoder, &frame);
-                frame.dfbit = currentTimecode.raw_data.ltc.dfbit;
-                ltc_encoder_set_frame(encoder, &frame);
-
-                ltc_encoder_encode_frame(encoder);
-
-                int numSamples = 0;
-                ltcsnd_sample_t *samples = ltc_encoder_get_bufptr(encoder, &numSamples, 1);
-                frameBuffer.assign(samples, samples + numSamples);
-            }
-
-            bool isLeapYear(int year) {
-                return ((year % 4 == 0) && (year % 100 != 0)) || (year % 400 == 0);
+                stream.show(smpte, currentTimecode.raw_data.ltc.dfbit != 0);
             }
 
-            int daysInMonth(int year, int month) {
-                static const int daysPerMonth[12] = {
-                    31, 28, 31, 30, 31, 30,
-                    31, 31, 30, 31, 30, 31
-                };
-
-                if (month == 2) {
-                    return isLeapYear(year) ? 29 : 28;
-                } else if (month >= 1 && month <= 12) {
-                    return daysPerMonth[month - 1];
+            // num_frames samples of LTC from sample position `at` on, into every stride'th float of ltc
+            void renderLtc(float *ltc, int num_frames, int stride, std::int64_t at) {
+                if (render_ahead_frames) {
+                    render_ring.read(ltc, num_frames, stride, at, [this](std::int64_t frame_start, const SentFrame &frame) {
+                        notifySend(frame_start, frame);
+                    });
                 } else {
-                    return 30; // fallback
+                    // the encoder resumes mid-frame
+                    stream.render(ltc, num_frames, stride, [&](int i) {
+                        // 次のフレームへ進める
+                        generateNextFrame();
+                        notifySend(at + i, frameToSend());
+                    });
                 }
             }
-        protected:
-            void threadedFunction() override {
-                while (isThreadRunning()) {
-                    const double ms_per_frame = 1000.0 / fps;
-                    const double sleep_buffer_ms = 1.0; // 微調整用バッファ（高負荷時の誤差吸収）
-                    const int samples_per_frame = int(encoder->sample_rate / fps); // 例: 44100 / 30 = 1470
 
-                    uint64_t now = ofGetElapsedTimeMillis();
+            void stopRenderAhead() {
+                if (!render_thread.joinable()) return;
+                render_running = false;
+                render_thread.join();
+            }
 
-                    if (!is_playing) {
-                        sleep(1);
+            // render-ahead worker, the only user of the encoder while it runs
+            void renderAhead() {
+                typedef RenderAheadRing<SentFrame> Ring;
+                typedef Ring::Block Block;
+                std::int64_t render_position = 0;
+                long long frame_index = 0;
+                while (render_running) {
+                    std::int64_t restart_position;
+                    const SentFrame *last_played;
+                    if (render_ring.restarted(restart_position, last_played)) {
+                        render_position = restart_position;
+                        // the frames rendered past it were never played, go on from the last one that was.
+                        // a setTimecode they took up is taken up again.
+                        if (last_played) {
+                            currentTimecode = makeTimecode(last_played->timecode);
+                            applied_locate = last_played->locate;
+                            frame_index = last_played->index + 1;
+                        } else {
+                            applied_locate = 0;
+                            frame_index = 0;
+                        }
+                        // the new generation starts where the last frame played ends,
+                        // with the frame lengths going on as before where the rate allows
+                        stream.restart(frame_index);
+                    }
+                    Block *block = render_ring.getWorkerGeneration() ? render_ring.acquire(render_position) : nullptr;
+                    if (!block) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
                         continue;
                     }
-
-                    // 経過時間からフレーム数算出
-                    long elapsed_ms = now - playback_start_elapsed_time;
-                    if (elapsed_ms < 0) elapsed_ms = 0;
-
-                    int frames_should_have_elapsed = int(elapsed_ms / ms_per_frame);
-                    int frames_to_advance = frames_should_have_elapsed - frames_already_advanced;
-
-                    if (frames_to_advance > 0) {
-                        for (int i = 0; i < frames_to_advance; ++i) {
-                            updateTimecode();
+                    stream.render(block->samples, Ring::block_size, 1, [&](int i) {
+                        generateNextFrame();
+                        SentFrame frame = frameToSend();
+                        frame.index = frame_index++;
+                        if (block->num_starts < Ring::max_starts) {
+                            block->start_offset[block->num_starts] = i;
+                            block->start_info[block->num_starts] = frame;
+                            ++block->num_starts;
                         }
-                        frames_already_advanced += frames_to_advance;
-                    }
-
-                    // LTCバッファが多すぎるなら削る（5フレーム以上溜まっていたら削る）
-
-                    sleep((int)(ms_per_frame - sleep_buffer_ms)); // 約1フレームごとにupdate
+                    });
+                    render_ring.commit(block);
+                    render_position += Ring::block_size;
                 }
             }
 
-            
             ofSoundStream soundStream;
-            LTCEncoder* encoder = nullptr;
+            EncoderStream stream;
             float fps = 30.0f;
             int sampleRate = 48000;
-            int samplesPerFrame = 0;
             size_t channel_offset = 0;
-            bool is_playing = false;
-            
-            long frames_already_advanced = 0;
-            long playback_start_elapsed_time = 0;
-            long pause_elapsed_time = 0;
+            std::atomic<std::uint64_t> output_mask{1};
+            std::atomic<OutputMode> output_mode{OutputMode::Replace};
+            static constexpr std::size_t mix_block_size = 1024;
+            std::vector<float> mix_buffer; // the LTC in Mix mode
+            std::atomic<bool> is_playing{false};
+            SeqLock<TimecodeSnapshot> located_timecode; // written by setTimecode
+            std::atomic<std::uint32_t> locate_request{0}; // setTimecode calls so far
+            std::uint32_t applied_locate = 0; // the last one encoded, the encoding side only
+            SeqLock<TimecodeSnapshot> sent; // written by the audio thread
+            std::atomic<std::uint32_t> sent_locate{0}; // the last one sent
             
-            std::vector<ltcsnd_sample_t> frameBuffer;
-            Timecode currentTimecode, startTimecode;
+            RenderAheadRing<SentFrame> render_ring;
+            std::size_t render_ahead_frames = 0;
+            std::thread render_thread;
+            std::atomic<bool> render_running{false};
+            Timecode currentTimecode{}; // of the frame being encoded, the encoding side only
+
+            SampleClock sample_clock;
+            std::int64_t position = 0; // samples produced so far
+            std::function<void(Timecode)> sendCallback{[](Timecode) {}};
         };
     };
 };
 
+#include "ofxLTC/Loopback.h"
+#include "ofxLTC/StreamHub.h"
+#include "ofxLTC/MultiChannelReceiver.h"
+#include "ofxLTC/RedundantReceiver.h"
+#include "ofxLTC/Replay.h"
+#include "ofxLTC/BwfRecorder.h"
+
 namespace ofxLTC = ofx::LTC;
 using ofxLTCTimecode = ofxLTC::Timecode;
 using ofxLTCReceiver = ofxLTC::Receiver;
@@ -0,0 +1,317 @@
+//
+//  AudioFile.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_AudioFile_h
+#define ofxLTC_AudioFile_h
+
+#include "ltc.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace ofx {
+    namespace LTC {
+        // read-only access to the samples of a WAV / BWF / RF64 or headerless PCM file.
+        // the file is memory mapped where the platform allows it and read in
+        // blocks otherwise. samples come out as libltc's unsigned 8 bit, one
+        // channel at a time. does not depend on openFrameworks.
+        class AudioFile {
+        public:
+            enum class Format {U8, S16, S24, S32, F32, F64};
+            
+            static std::size_t bytesPerSample(Format format) {
+                switch(format) {
+                    case Format::U8: return 1;
+                    case Format::S16: return 2;
+                    case Format::S24: return 3;
+                    case Format::S32: return 4;
+                    case Format::F32: return 4;
+                    case Format::F64: return 8;
+                }
+                return 0;
+            }
+            
+            // "u8", "s16", "s24", "s32", "f32", "f64"
+            static bool parseFormat(const std::string &name, Format &format) {
+                static const char *names[] = {"u8", "s16", "s24", "s32", "f32", "f64"};
+                for(int i = 0; i < 6; ++i) {
+                    if(name == names[i]) {
+                        format = static_cast<Format>(i);
+                        return true;
+                    }
+                }
+                return false;
+            }
+            
+            AudioFile() = default;
+            AudioFile(const AudioFile &) = delete;
+            AudioFile &operator=(const AudioFile &) = delete;
+            ~AudioFile()
+            { close(); };
+            
+            // RIFF/WAVE (incl. BWF) and RF64/BW64, integer or float PCM
+            bool open(const std::string &path) {
+                if(!openFile(path)) return false;
+                unsigned char header[12];
+                if(!readAt(0, header, 12)) return fail("file too short");
+                const bool rf64 = !std::memcmp(header, "RF64", 4) || !std::memcmp(header, "BW64", 4);
+                if((std::memcmp(header, "RIFF", 4) && !rf64) || std::memcmp(header + 8, "WAVE", 4)) {
+                    return fail("not a WAVE file");
+                }
+                
+                std::uint64_t ds64_data_size = 0;
+                bool has_fmt = false;
+                std::uint64_t pos = 12;
+                while(pos + 8 <= file_size) {
+                    unsigned char chunk[8];
+                    readAt(pos, chunk, 8);
+                    std::uint64_t size = le32(chunk + 4);
+                    const std::uint64_t body = pos + 8;
+                    if(!std::memcmp(chunk, "ds64", 4) && 16 <= size) {
+                        unsigned char ds64[16] = {0};
+                        readAt(body, ds64, 16);
+                        ds64_data_size = le64(ds64 + 8);
+                    } else if(!std::memcmp(chunk, "fmt ", 4) && 16 <= size) {
+                        unsigned char fmt[40] = {0};
+                        readAt(body, fmt, std::min<std::uint64_t>(size, 40));
+                        unsigned int tag = le16(fmt);
+                        const unsigned int bits = le16(fmt + 14);
+                        if(tag == 0xFFFE && 40 <= size) tag = le16(fmt + 24);
+                        num_channels = le16(fmt + 2);
+                        sample_rate = le32(fmt + 4);
+                        if(tag == 1 && bits == 8) format = Format::U8;
+                        else if(tag == 1 && bits == 16) format = Format::S16;
+                        else if(tag == 1 && bits == 24) format = Format::S24;
+                        else if(tag == 1 && bits == 32) format = Format::S32;
+                        else if(tag == 3 && bits == 32) format = Format::F32;
+                        else if(tag == 3 && bits == 64) format = Format::F64;
+                        else return fail("unsupported sample format");
+                        has_fmt = true;
+                    } else if(!std::memcmp(chunk, "data", 4)) {
+                        if(!has_fmt || num_channels == 0) return fail("data before fmt chunk");
+                        if(rf64 && size == 0xFFFFFFFFu) size = ds64_data_size;
+                        return setData(body, size);
+                    }
+                    pos = body + size + (size & 1);
+                }
+                return fail("no data chunk");
+            }
+            
+            // headerless interleaved little endian PCM, starting `offset` bytes into the file
+            bool openRaw(const std::string &path, Format format, std::size_t num_channels,
+                         double sample_rate, std::uint64_t offset = 0)
+            {
+                if(!openFile(path)) return false;
+                if(num_channels == 0) return fail("no channels");
+                this->format = format;
+                this->num_channels = num_channels;
+                this->sample_rate = sample_rate;
+                return setData(offset, file_size - std::min(offset, file_size));
+            }
+            
+            void close() {
+#ifndef _WIN32
+                if(mapped) munmap(const_cast<unsigned char *>(mapped), static_cast<std::size_t>(file_size));
+                if(0 <= fd) ::close(fd);
+                fd = -1;
+#endif
+                if(stream) std::fclose(stream);
+                stream = nullptr;
+                mapped = nullptr;
+                file_size = data_offset = 0;
+                num_frames = 0;
+            }
+            
+            bool isOpen() const
+            { return mapped || stream; };
+            
+            bool isMapped() const
+            { return mapped != nullptr; };
+            
+            const std::string &getError() const
+            { return error; };
+            
+            std::int64_t getNumFrames() const
+            { return num_frames; };
+            
+            std::size_t getNumChannels() const
+            { return num_channels; };
+            
+            double getSampleRate() const
+            { return sample_rate; };
+            
+            Format getFormat() const
+            { return format; };
+            
+            // byte offset of the first sample, e.g. for writing a header in place
+            std::uint64_t getDataOffset() const
+            { return data_offset; };
+            
+            // `count` sample frames of `channel` from `frame` on as libltc samples.
+            // returns the number of samples written, less than count at the end of the file.
+            // safe to call from several threads.
+            std::size_t read(std::int64_t frame, std::size_t count, std::size_t channel,
+                             ltcsnd_sample_t *out) const
+            {
+                if(channel >= num_channels || frame < 0 || num_frames <= frame) return 0;
+                count = static_cast<std::size_t>(std::min<std::int64_t>(count, num_frames - frame));
+                const std::size_t width = bytesPerSample(format);
+                const std::size_t stride = width * num_channels;
+                const std::uint64_t offset = data_offset + frame * stride + channel * width;
+                if(mapped) {
+                    convert(mapped + offset, count, stride, out);
+                    return count;
+                }
+                
+                // one block of whole sample frames at a time
+                thread_local std::vector<unsigned char> block;
+                const std::size_t per_block = std::max<std::size_t>(1, (1 << 16) / stride);
+                std::size_t done = 0;
+                while(done < count) {
+                    const std::size_t n = std::min(per_block, count - done);
+                    block.resize(n * stride);
+                    {
+                        std::lock_guard<std::mutex> lock(stream_mutex);
+                        if(!readAt(offset + done * stride, block.data(), (n - 1) * stride + width)) break;
+                    }
+                    convert(block.data(), n, stride, out + done);
+                    done += n;
+                }
+                return done;
+            }
+            
+        protected:
+            static unsigned int le16(const unsigned char *p)
+            { return p[0] | (p[1] << 8); };
+            
+            static std::uint32_t le32(const unsigned char *p)
+            { return le16(p) | (static_cast<std::uint32_t>(le16(p + 2)) << 16); };
+            
+            static std::uint64_t le64(const unsigned char *p)
+            { return le32(p) | (static_cast<std::uint64_t>(le32(p + 4)) << 32); };
+            
+            // integer PCM keeps its most significant byte, which for little endian
+            // signed samples is the last one with the sign flipped. floats map like
+            // ltc_decoder_write_float().
+            void convert(const unsigned char *src, std::size_t count, std::size_t stride,
+                         ltcsnd_sample_t *out) const
+            {
+                switch(format) {
+                    case Format::U8:
+                        for(std::size_t i = 0; i < count; ++i) out[i] = src[i * stride];
+                        break;
+                    case Format::S16:
+                    case Format::S24:
+                    case Format::S32: {
+                        const std::size_t msb = bytesPerSample(format) - 1;
+                        for(std::size_t i = 0; i < count; ++i) out[i] = src[i * stride + msb] ^ 0x80;
+                        break;
+                    }
+                    case Format::F32:
+                        for(std::size_t i = 0; i < count; ++i) {
+                            float v;
+                            std::memcpy(&v, src + i * stride, sizeof(v));
+                            out[i] = toSample(v);
+                        }
+                        break;
+                    case Format::F64:
+                        for(std::size_t i = 0; i < count; ++i) {
+                            double v;
+                            std::memcpy(&v, src + i * stride, sizeof(v));
+                            out[i] = toSample(static_cast<float>(v));
+                        }
+                        break;
+                }
+            }
+            
+            static ltcsnd_sample_t toSample(float v) {
+                v = std::max(-1.0f, std::min(1.0f, v));
+                return static_cast<ltcsnd_sample_t>(128 + v * 127.0f);
+            }
+            
+            bool openFile(const std::string &path) {
+                close();
+                error.clear();
+                stream = std::fopen(path.c_str(), "rb");
+                if(!stream) return fail("cannot open " + path);
+                std::fseek(stream, 0, SEEK_END);
+#ifdef _WIN32
+                file_size = static_cast<std::uint64_t>(_ftelli64(stream));
+#else
+                file_size = static_cast<std::uint64_t>(ftello(stream));
+#endif
+#ifndef _WIN32
+                fd = ::open(path.c_str(), O_RDONLY);
+                if(0 <= fd && file_size) {
+                    void *p = mmap(nullptr, static_cast<std::size_t>(file_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                    if(p != MAP_FAILED) {
+                        madvise(p, static_cast<std::size_t>(file_size), MADV_SEQUENTIAL);
+                        mapped = static_cast<const unsigned char *>(p);
+                        std::fclose(stream);
+                        stream = nullptr;
+                    }
+                }
+#endif
+                return true;
+            }
+            
+            bool readAt(std::uint64_t offset, unsigned char *dst, std::size_t size) const {
+                if(file_size < offset + size) return false;
+                if(mapped) {
+                    std::memcpy(dst, mapped + offset, size);
+                    return true;
+                }
+#ifdef _WIN32
+                if(_fseeki64(stream, static_cast<__int64>(offset), SEEK_SET)) return false;
+#else
+                if(fseeko(stream, static_cast<off_t>(offset), SEEK_SET)) return false;
+#endif
+                return std::fread(dst, 1, size, stream) == size;
+            }
+            
+            // a truncated recording keeps the frames that made it to disk
+            bool setData(std::uint64_t offset, std::uint64_t size) {
+                data_offset = offset;
+                const std::uint64_t available = file_size - std::min(offset, file_size);
+                num_frames = static_cast<std::int64_t>(std::min(size, available) / (bytesPerSample(format) * num_channels));
+                return true;
+            }
+            
+            bool fail(const std::string &message) {
+                close();
+                error = message;
+                return false;
+            }
+            
+            std::FILE *stream{nullptr};
+            mutable std::mutex stream_mutex;
+            const unsigned char *mapped{nullptr};
+#ifndef _WIN32
+            int fd{-1};
+#endif
+            std::uint64_t file_size{0};
+            std::uint64_t data_offset{0};
+            std::int64_t num_frames{0};
+            std::size_t num_channels{0};
+            double sample_rate{0.0};
+            Format format{Format::S16};
+            std::string error;
+        };
+    };
+};
+
+#endif /* ofxLTC_AudioFile_h */
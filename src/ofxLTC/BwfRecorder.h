@@ -0,0 +1,177 @@
+//
+//  BwfRecorder.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_BwfRecorder_h
+#define ofxLTC_BwfRecorder_h
+
+#include "../ofxLTC.h"
+#include "BwfWriter.h"
+#include "FrameCount.h"
+
+#include <atomic>
+#include <cmath>
+#include <string>
+
+namespace ofx {
+    namespace LTC {
+        // records the input to a Broadcast Wave file and stamps its bext
+        // TimeReference from the LTC on one of the channels.
+        //
+        // every decoded frame tells where the file's first sample falls in the
+        // day: its timecode in samples minus its offset into the file. the first
+        // frame sets the TimeReference right away, once stable_frames frames in a
+        // row agree within a quarter bit it is replaced by their mean for good.
+        // the LTC channel can be left out of the file.
+        // note: installs its own onFrame handler on the receiver.
+        class BwfRecorder {
+        public:
+            struct Settings {
+                std::string path;
+                std::size_t ltc_channel{0};
+                bool strip_ltc{false}; // leave the LTC channel out of the file
+                AudioFile::Format format{AudioFile::Format::S24};
+                double fps{0.0}; // of the timecode, 0: from the signal, 29.97 with drop-frame
+                std::size_t stable_frames{25};
+                double buffer_seconds{2.0};
+                std::string description;
+                std::string originator;
+            };
+            
+            ~BwfRecorder()
+            { stop(); };
+            
+            // opens an input sound stream and starts recording all of its channels
+            bool setup(const ofSoundStreamSettings &stream_settings, const Settings &settings) {
+                ofSoundStreamSettings settings_ = stream_settings;
+                settings_.setInListener(this);
+                if(!setupRecorder(settings_.sampleRate, settings_.numInputChannels, settings)) return false;
+                return soundStream.setup(settings_);
+            }
+            
+            // without a sound stream, feed audioIn / process yourself (e.g. from a Replay)
+            bool setupRecorder(double sample_rate, std::size_t num_channels, const Settings &settings) {
+                stop();
+                this->settings = settings;
+                this->sample_rate = sample_rate;
+                receiver.setupDecoder(sample_rate, settings.ltc_channel);
+                receiver.onFrame([this](const LTCFrameExt &frame, bool extrapolated, double) {
+                    if(!extrapolated) stamp(frame);
+                });
+                
+                BwfWriter::Settings writer_settings;
+                writer_settings.path = settings.path;
+                writer_settings.sample_rate = sample_rate;
+                writer_settings.num_channels = num_channels;
+                for(std::size_t c = 0; c < num_channels; ++c) {
+                    if(!settings.strip_ltc || c != settings.ltc_channel) writer_settings.channels.push_back(c);
+                }
+                writer_settings.format = settings.format;
+                writer_settings.buffer_seconds = settings.buffer_seconds;
+                writer_settings.description = settings.description;
+                writer_settings.originator = settings.originator;
+                position = 0;
+                has_start = false;
+                has_reference = false;
+                stable = false;
+                run_length = 0;
+                if(!writer.open(writer_settings)) {
+                    ofLogError() << "[LTC] BwfRecorder: " << writer.getError();
+                    return false;
+                }
+                return true;
+            }
+            
+            // closes the sound stream and finishes the file
+            void stop() {
+                soundStream.close();
+                writer.close();
+            }
+            
+            void audioIn(ofSoundBuffer &buffer) {
+                process(buffer, position, getMonotonicTime());
+            }
+            
+            void process(const ofSoundBuffer &buffer, std::int64_t position, double arrival) {
+                if(!has_start) {
+                    start = position;
+                    has_start = true;
+                }
+                receiver.process(buffer, position, arrival);
+                writer.write(buffer.getBuffer().data(), buffer.getNumFrames(), buffer.getNumChannels());
+                this->position = position + static_cast<std::int64_t>(buffer.getNumFrames());
+            }
+            
+            Receiver &getReceiver()
+            { return receiver; };
+            
+            bool hasTimeReference() const
+            { return has_reference.load(); };
+            
+            // the TimeReference no longer changes
+            bool isTimeReferenceStable() const
+            { return stable.load(); };
+            
+            std::uint64_t getTimeReference() const
+            { return writer.getTimeReference(); };
+            
+            // sample frames lost because the disk fell behind
+            std::uint64_t getOverruns() const
+            { return writer.getOverruns(); };
+            
+            const BwfWriter &getWriter() const
+            { return writer; };
+            
+        protected:
+            // where the first sample of the file falls in the day, from one frame
+            bool estimate(const LTCFrameExt &frame, double &reference) const {
+                if(frame.reverse) return false;
+                const bool drop_frame = frame.ltc.dfbit != 0;
+                const int fps = drop_frame ? 30 : receiver.getFps();
+                if(fps <= 0) return false;
+                const double rate = 0.0 < settings.fps ? settings.fps : (drop_frame ? 30000.0 / 1001.0 : fps);
+                const double day = framesPerDay(fps, drop_frame) / rate * sample_rate;
+                reference = toFrameCount(frame.ltc, fps) / rate * sample_rate - static_cast<double>(frame.off_start - start);
+                reference = std::fmod(reference, day);
+                if(reference < 0.0) reference += day;
+                return true;
+            }
+            
+            void stamp(const LTCFrameExt &frame) {
+                if(stable.load()) return;
+                double reference;
+                if(!estimate(frame, reference)) return;
+                if(!has_reference.load()) {
+                    writer.setTimeReference(static_cast<std::uint64_t>(std::llround(reference)));
+                    has_reference = true;
+                }
+                // consecutive frames agree up to the decoder's jitter
+                const double tolerance = sample_rate / receiver.getFps() / (4 * LTC_FRAME_BIT_COUNT);
+                if(run_length && tolerance < std::abs(reference - run_sum / run_length)) run_length = 0;
+                if(!run_length) run_sum = 0.0;
+                run_sum += reference;
+                ++run_length;
+                if(settings.stable_frames <= run_length) {
+                    writer.setTimeReference(static_cast<std::uint64_t>(std::llround(run_sum / run_length)));
+                    stable = true;
+                }
+            }
+            
+            Settings settings;
+            ofSoundStream soundStream;
+            Receiver receiver;
+            BwfWriter writer;
+            double sample_rate{48000.0};
+            std::int64_t position{0}; // next stream sample
+            std::int64_t start{0}; // stream sample of the file's first sample
+            bool has_start{false};
+            std::atomic<bool> has_reference{false};
+            std::atomic<bool> stable{false};
+            double run_sum{0.0};
+            std::size_t run_length{0};
+        };
+    };
+};
+
+#endif /* ofxLTC_BwfRecorder_h */
@@ -0,0 +1,342 @@
+//
+//  BwfWriter.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_BwfWriter_h
+#define ofxLTC_BwfWriter_h
+
+#include "AudioFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ofx {
+    namespace LTC {
+        // streams interleaved float audio to a Broadcast Wave file.
+        // write() is called from the audio thread: it converts into a ring
+        // buffer and never blocks, locks or allocates. a writer thread hands
+        // whole runs of the ring to the OS without another copy, keeps the
+        // header sizes current about once a second so a crashed recording stays
+        // readable, and switches to RF64 (EBU Tech 3306) once the file outgrows 4 GB.
+        // does not depend on openFrameworks.
+        class BwfWriter {
+        public:
+            struct Settings {
+                std::string path;
+                double sample_rate{48000.0};
+                std::size_t num_channels{2}; // of the interleaved input
+                std::vector<std::size_t> channels; // input channel of each file channel, empty: all
+                AudioFile::Format format{AudioFile::Format::S24};
+                double buffer_seconds{2.0}; // of the ring between the audio thread and the disk
+                std::size_t write_size{1 << 20}; // bytes the writer waits for before writing
+                std::string description; // bext
+                std::string originator;
+            };
+            
+            BwfWriter() = default;
+            BwfWriter(const BwfWriter &) = delete;
+            BwfWriter &operator=(const BwfWriter &) = delete;
+            ~BwfWriter()
+            { close(); };
+            
+            bool open(const Settings &settings) {
+                close();
+                this->settings = settings;
+                if(this->settings.channels.empty()) {
+                    for(std::size_t c = 0; c < settings.num_channels; ++c) this->settings.channels.push_back(c);
+                }
+                for(std::size_t c : this->settings.channels) {
+                    if(settings.num_channels <= c) return fail("no input channel " + std::to_string(c));
+                }
+                if(this->settings.channels.empty()) return fail("no channels");
+                if(settings.format == AudioFile::Format::U8 || settings.format == AudioFile::Format::F64) {
+                    return fail("unsupported sample format");
+                }
+                sample_bytes = AudioFile::bytesPerSample(settings.format);
+                frame_bytes = sample_bytes * this->settings.channels.size();
+                full_scale = std::ldexp(1.0, static_cast<int>(sample_bytes * 8 - 1));
+                max_value = static_cast<std::int64_t>(full_scale) - 1;
+                capacity = std::max<std::size_t>(1024, static_cast<std::size_t>(settings.sample_rate * settings.buffer_seconds));
+                ring.assign(capacity * frame_bytes, 0);
+                write_index = read_index = 0;
+                overruns = 0;
+                written = 0;
+                time_reference = 0;
+                time_reference_version = 0;
+                header_version = 0;
+                data_bytes = 0;
+                rf64 = false;
+                
+                file = std::fopen(settings.path.c_str(), "wb");
+                if(!file) return fail("cannot open " + settings.path);
+                // the ring is the buffer, every fwrite goes straight to the OS
+                std::setvbuf(file, nullptr, _IONBF, 0);
+                const std::vector<unsigned char> header = makeHeader();
+                if(std::fwrite(header.data(), 1, header.size(), file) != header.size()) {
+                    std::fclose(file);
+                    file = nullptr;
+                    return fail("cannot write " + settings.path);
+                }
+                running = true;
+                writer = std::thread([this] { work(); });
+                return true;
+            }
+            
+            // writes what is buffered and the final header
+            void close() {
+                if(!writer.joinable()) return;
+                running = false;
+                writer.join();
+            }
+            
+            bool isOpen() const
+            { return writer.joinable(); };
+            
+            // from the audio thread only. `frames` sample frames of num_channels
+            // floats each, `stride` floats apart (0: num_channels).
+            // returns the frames taken, the rest are counted as overruns.
+            std::size_t write(const float *samples, std::size_t frames, std::size_t stride = 0) {
+                if(!stride) stride = settings.num_channels;
+                const std::uint64_t w = write_index.load(std::memory_order_relaxed);
+                const std::uint64_t r = read_index.load(std::memory_order_acquire);
+                const std::size_t n = std::min<std::size_t>(frames, capacity - static_cast<std::size_t>(w - r));
+                for(std::size_t i = 0; i < n; ++i) {
+                    unsigned char *dst = ring.data() + static_cast<std::size_t>((w + i) % capacity) * frame_bytes;
+                    const float *src = samples + i * stride;
+                    for(std::size_t c : settings.channels) {
+                        encode(src[c], dst);
+                        dst += sample_bytes;
+                    }
+                }
+                write_index.store(w + n, std::memory_order_release);
+                if(n < frames) overruns.fetch_add(frames - n, std::memory_order_relaxed);
+                return n;
+            }
+            
+            // bext TimeReference, the first sample's count since midnight.
+            // callable from any thread, the header is updated by the writer thread.
+            void setTimeReference(std::uint64_t samples) {
+                time_reference.store(samples);
+                time_reference_version.fetch_add(1);
+            }
+            
+            std::uint64_t getTimeReference() const
+            { return time_reference.load(); };
+            
+            // sample frames write() had no room for
+            std::uint64_t getOverruns() const
+            { return overruns.load(); };
+            
+            std::uint64_t getFramesWritten() const
+            { return written.load(); };
+            
+            // frames waiting in the ring
+            std::size_t getBuffered() const
+            { return static_cast<std::size_t>(write_index.load() - read_index.load()); };
+            
+            std::size_t getCapacity() const
+            { return capacity; };
+            
+            std::size_t getNumFileChannels() const
+            { return settings.channels.size(); };
+            
+            const std::string &getError() const
+            { return error; };
+            
+        protected:
+            // offsets into the header
+            enum : std::size_t {
+                riff_size_at = 4,
+                ds64_at = 12, // a JUNK chunk until the file needs RF64
+                bext_at = ds64_at + 8 + 28,
+                time_reference_at = bext_at + 8 + 256 + 32 + 32 + 10 + 8,
+                bext_size = 602,
+            };
+            
+            static void put(std::vector<unsigned char> &out, std::size_t at, std::uint64_t value, std::size_t bytes) {
+                for(std::size_t i = 0; i < bytes; ++i) out[at + i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+            
+            static void append(std::vector<unsigned char> &out, const char *id, std::uint64_t value, std::size_t bytes) {
+                out.insert(out.end(), id, id + std::strlen(id));
+                out.resize(out.size() + bytes);
+                put(out, out.size() - bytes, value, bytes);
+            }
+            
+            std::vector<unsigned char> makeHeader() {
+                std::vector<unsigned char> h;
+                append(h, "RIFF", 0, 4);
+                append(h, "WAVE", 0, 0);
+                append(h, "JUNK", 28, 4);
+                h.resize(h.size() + 28, 0);
+                
+                append(h, "bext", bext_size, 4);
+                const std::size_t bext = h.size();
+                h.resize(h.size() + bext_size, 0);
+                std::memcpy(&h[bext], settings.description.data(), std::min<std::size_t>(256, settings.description.size()));
+                std::memcpy(&h[bext + 256], settings.originator.data(), std::min<std::size_t>(32, settings.originator.size()));
+                const std::time_t now = std::time(nullptr);
+                char date[20];
+                std::strftime(date, sizeof(date), "%Y-%m-%d%H:%M:%S", std::localtime(&now));
+                std::memcpy(&h[bext + 320], date, 18);
+                put(h, time_reference_at, time_reference.load(), 8);
+                put(h, bext + 346, 1, 2); // version
+                
+                const bool is_float = settings.format == AudioFile::Format::F32;
+                const std::size_t bits = sample_bytes * 8;
+                const std::size_t channels = settings.channels.size();
+                const bool extensible = 2 < channels || 16 < bits;
+                append(h, "fmt ", extensible ? 40 : 16, 4);
+                const std::size_t fmt = h.size();
+                h.resize(h.size() + (extensible ? 40 : 16), 0);
+                put(h, fmt, extensible ? 0xFFFE : (is_float ? 3 : 1), 2);
+                put(h, fmt + 2, channels, 2);
+                put(h, fmt + 4, static_cast<std::uint64_t>(settings.sample_rate), 4);
+                put(h, fmt + 8, static_cast<std::uint64_t>(settings.sample_rate) * frame_bytes, 4);
+                put(h, fmt + 12, frame_bytes, 2);
+                put(h, fmt + 14, bits, 2);
+                if(extensible) {
+                    static const unsigned char guid[14] = {0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+                    put(h, fmt + 16, 22, 2);
+                    put(h, fmt + 18, bits, 2);
+                    put(h, fmt + 24, is_float ? 3 : 1, 2);
+                    std::memcpy(&h[fmt + 26], guid, sizeof(guid));
+                }
+                
+                append(h, "data", 0, 4);
+                data_at = h.size();
+                put(h, riff_size_at, data_at - 8, 4);
+                return h;
+            }
+            
+            void encode(float v, unsigned char *dst) const {
+                if(settings.format == AudioFile::Format::F32) {
+                    std::memcpy(dst, &v, sizeof(v));
+                    return;
+                }
+                v = std::max(-1.0f, std::min(1.0f, v));
+                const std::int64_t value = std::min<std::int64_t>(std::llrint(v * full_scale), max_value);
+                for(std::size_t i = 0; i < sample_bytes; ++i) dst[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+            
+            void work() {
+                const std::size_t run = std::max<std::size_t>(1, settings.write_size / frame_bytes);
+                const std::uint64_t header_every = static_cast<std::uint64_t>(settings.sample_rate);
+                std::uint64_t header_at = header_every;
+                while(true) {
+                    const bool stopping = !running.load();
+                    const std::uint64_t r = read_index.load(std::memory_order_relaxed);
+                    const std::uint64_t available = write_index.load(std::memory_order_acquire) - r;
+                    if(!stopping && available < run) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                        continue;
+                    }
+                    if(available == 0) break;
+                    // up to the end of the ring, the rest next time round
+                    const std::size_t at = static_cast<std::size_t>(r % capacity);
+                    const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(available, capacity - at));
+                    if(std::fwrite(ring.data() + at * frame_bytes, frame_bytes, n, file) != n) {
+                        error = "write failed";
+                        overruns.fetch_add(n, std::memory_order_relaxed);
+                    } else {
+                        data_bytes += static_cast<std::uint64_t>(n) * frame_bytes;
+                        written.fetch_add(n, std::memory_order_relaxed);
+                    }
+                    read_index.store(r + n, std::memory_order_release);
+                    if(header_at <= written.load() || time_reference_version.load() != header_version) {
+                        updateHeader();
+                        header_at = written.load() + header_every;
+                    }
+                }
+                if(data_bytes & 1) std::fputc(0, file);
+                updateHeader();
+                std::fclose(file);
+                file = nullptr;
+            }
+            
+            void patch(std::uint64_t at, std::uint64_t value, std::size_t bytes) {
+                unsigned char b[8];
+                for(std::size_t i = 0; i < bytes; ++i) b[i] = static_cast<unsigned char>(value >> (8 * i));
+                seek(at);
+                std::fwrite(b, 1, bytes, file);
+            }
+            
+            void seek(std::uint64_t at) {
+#ifdef _WIN32
+                _fseeki64(file, static_cast<__int64>(at), SEEK_SET);
+#else
+                fseeko(file, static_cast<off_t>(at), SEEK_SET);
+#endif
+            }
+            
+            // sizes and TimeReference, then back to the end of the data
+            void updateHeader() {
+                header_version = time_reference_version.load();
+                patch(time_reference_at, time_reference.load(), 8);
+                const std::uint64_t riff_size = data_at + data_bytes + (data_bytes & 1) - 8;
+                if(!rf64 && 0xFFFFFFFFull <= riff_size) {
+                    rf64 = true;
+                    seek(0);
+                    std::fwrite("RF64", 1, 4, file);
+                    seek(ds64_at);
+                    std::fwrite("ds64", 1, 4, file);
+                    patch(riff_size_at, 0xFFFFFFFFull, 4);
+                    patch(data_at - 4, 0xFFFFFFFFull, 4);
+                }
+                if(rf64) {
+                    patch(ds64_at + 8, riff_size, 8);
+                    patch(ds64_at + 16, data_bytes, 8);
+                    patch(ds64_at + 24, data_bytes / frame_bytes, 8);
+                } else {
+                    patch(riff_size_at, riff_size, 4);
+                    patch(data_at - 4, data_bytes, 4);
+                }
+                seek(data_at + data_bytes);
+            }
+            
+            bool fail(const std::string &message) {
+                error = message;
+                return false;
+            }
+            
+            Settings settings;
+            std::string error;
+            std::size_t sample_bytes{3};
+            std::size_t frame_bytes{6};
+            double full_scale{8388608.0};
+            std::int64_t max_value{8388607};
+            
+            // single producer / single consumer ring of sample frames
+            std::vector<unsigned char> ring;
+            std::size_t capacity{0};
+            std::atomic<std::uint64_t> write_index{0};
+            std::atomic<std::uint64_t> read_index{0};
+            std::atomic<std::uint64_t> overruns{0};
+            std::atomic<std::uint64_t> written{0};
+            
+            std::atomic<std::uint64_t> time_reference{0};
+            std::atomic<std::uint32_t> time_reference_version{0};
+            
+            // writer thread
+            std::thread writer;
+            std::atomic<bool> running{false};
+            std::FILE *file{nullptr};
+            std::uint64_t data_at{0};
+            std::uint64_t data_bytes{0};
+            std::uint32_t header_version{0};
+            bool rf64{false};
+        };
+    };
+};
+
+#endif /* ofxLTC_BwfWriter_h */
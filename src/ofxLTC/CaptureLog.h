@@ -0,0 +1,639 @@
+//
+//  CaptureLog.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_CaptureLog_h
+#define ofxLTC_CaptureLog_h
+
+#include "ltc.h"
+#include "SpscQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#   include <io.h>
+#else
+#   include <unistd.h>
+#endif
+
+namespace ofx {
+    namespace LTC {
+        // one logged frame, or one sound buffer the receiver was given
+        struct CaptureEntry {
+            std::int64_t off_start; // for a buffer its first and last stream sample
+            std::int64_t off_end;
+            unsigned char ltc[LTC_FRAME_BIT_COUNT / 8]; // the first 10 bytes of LTCFrame
+            bool reverse;
+            bool extrapolated;
+            float volume; // dBFS, logged with 0.01 dB resolution
+            double time; // whatever clock the producer uses, e.g. getMonotonicTime(), logged with 1 us resolution
+            bool buffer; // for a buffer time is its arrival
+            
+            static CaptureEntry make(const LTCFrameExt &frame, bool extrapolated, double time) {
+                CaptureEntry entry{};
+                entry.off_start = frame.off_start;
+                entry.off_end = frame.off_end;
+                std::memcpy(entry.ltc, &frame.ltc, sizeof(entry.ltc));
+                entry.reverse = frame.reverse != 0;
+                entry.extrapolated = extrapolated;
+                entry.volume = static_cast<float>(frame.volume);
+                entry.time = time;
+                return entry;
+            }
+            
+            static CaptureEntry makeBuffer(std::int64_t position, std::size_t frames, double arrival) {
+                CaptureEntry entry{};
+                entry.off_start = position;
+                entry.off_end = position + static_cast<std::int64_t>(frames) - 1;
+                entry.time = arrival;
+                entry.buffer = true;
+                return entry;
+            }
+            
+            LTCFrame frame() const {
+                LTCFrame f;
+                std::memset(&f, 0, sizeof(f));
+                std::memcpy(&f, ltc, sizeof(ltc));
+                return f;
+            }
+        };
+        
+        // the byte format shared by CaptureLogWriter and CaptureLogReader.
+        //
+        // a file starts with "LTCL", a u32 version and the f64 sample rate.
+        // records follow back to back. a sync record carries a whole frame:
+        //   0xFF "SYNC" u8 fps, i64 off_start, i64 off_end, 10 byte LTC word, u8 flags,
+        //   i16 volume (0.01 dB), f64 time, u64 wall clock (us since 1970),
+        //   u32 frames dropped since the last sync, u32 CRC-32 of the previous segment
+        //   (the last sync record and the deltas after it), u32 CRC-32 of this record.
+        // every other frame is a delta to the one before, tag byte < 0x80 first:
+        //   zigzag varint gap (off_start - previous off_end - 1)
+        //   zigzag varint change of length (off_end - off_start)
+        //   10 byte LTC word unless it is the previous one incremented (decremented in reverse)
+        //   zigzag varint volume change unless unchanged
+        //   zigzag varint time in us off the sample position prediction unless exact
+        // a frame following on from the previous one takes 3 bytes. a buffer is
+        // tagged Buffer and stored relative to the buffer or sync record before it:
+        //   zigzag varint gap (first sample - previous end), zigzag varint length,
+        //   zigzag varint arrival in us off the sample position prediction unless exact
+        // a file ends with a sync record flagged End that carries no frame, only
+        // a file cut off by a crash has an unchecked segment at its end.
+        // all integers are little endian.
+        struct CaptureLogFormat {
+            enum : std::uint8_t {
+                PredictedWord = 0x01,
+                Reverse = 0x02,
+                Extrapolated = 0x04,
+                SameVolume = 0x08,
+                PredictedTime = 0x10,
+                Buffer = 0x40,
+                End = 0x80, // sync records only
+                Sync = 0xFF,
+            };
+            static constexpr std::size_t header_size = 16;
+            static constexpr std::size_t sync_size = 63;
+            
+            // continues `crc` if given the CRC of the bytes before
+            static std::uint32_t crc32(const unsigned char *data, std::size_t size, std::uint32_t crc = 0) {
+                static const std::vector<std::uint32_t> table = [] {
+                    std::vector<std::uint32_t> t(256);
+                    for(std::uint32_t i = 0; i < 256; ++i) {
+                        std::uint32_t c = i;
+                        for(int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                        t[i] = c;
+                    }
+                    return t;
+                }();
+                crc ^= 0xFFFFFFFFu;
+                for(std::size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+                return crc ^ 0xFFFFFFFFu;
+            }
+            
+            static void put(std::vector<unsigned char> &out, std::uint64_t value, std::size_t bytes) {
+                for(std::size_t i = 0; i < bytes; ++i) out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+            }
+            
+            static std::uint64_t get(const unsigned char *p, std::size_t bytes) {
+                std::uint64_t value = 0;
+                for(std::size_t i = 0; i < bytes; ++i) value |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+                return value;
+            }
+            
+            static void putVarint(std::vector<unsigned char> &out, std::int64_t value) {
+                std::uint64_t zigzag = (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+                while(0x80 <= zigzag) {
+                    out.push_back(static_cast<unsigned char>(zigzag | 0x80));
+                    zigzag >>= 7;
+                }
+                out.push_back(static_cast<unsigned char>(zigzag));
+            }
+            
+            static bool getVarint(const unsigned char *&p, const unsigned char *end, std::int64_t &value) {
+                std::uint64_t zigzag = 0;
+                for(int shift = 0; shift < 64; shift += 7) {
+                    if(p == end) return false;
+                    const unsigned char byte = *p++;
+                    zigzag |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+                    if(!(byte & 0x80)) {
+                        value = static_cast<std::int64_t>(zigzag >> 1) ^ -static_cast<std::int64_t>(zigzag & 1);
+                        return true;
+                    }
+                }
+                return false;
+            }
+            
+            static std::int64_t centiDecibel(float volume)
+            { return std::isfinite(volume) ? std::llround(volume * 100.0) : -32768; };
+            
+            // the next LTC word if the timecode simply runs on
+            static void predictWord(const unsigned char *previous, bool reverse, int fps, unsigned char *out) {
+                LTCFrame f;
+                std::memset(&f, 0, sizeof(f));
+                std::memcpy(&f, previous, LTC_FRAME_BIT_COUNT / 8);
+                if(0 < fps) {
+                    const auto standard = (fps == 25) ? LTC_TV_625_50 : LTC_TV_525_60;
+                    if(reverse) ltc_frame_decrement(&f, fps, standard, LTC_USE_DATE);
+                    else ltc_frame_increment(&f, fps, standard, LTC_USE_DATE);
+                }
+                std::memcpy(out, &f, LTC_FRAME_BIT_COUNT / 8);
+            }
+            
+            // the time a frame is expected at from the previous one and the sample rate
+            static double predictTime(const CaptureEntry &previous, std::int64_t off_end, double sample_rate)
+            { return previous.time + (off_end - previous.off_end) / sample_rate; };
+            
+            // the arrival of a buffer ending at `end` from the one before, see predictTime
+            static double predictArrival(std::int64_t previous_end, double previous_time, std::int64_t end, double sample_rate)
+            { return previous_time + (end - previous_end) / sample_rate; };
+            
+            static int guessFps(const CaptureEntry &entry, double sample_rate) {
+                const double measured = sample_rate / (entry.off_end - entry.off_start + 1);
+                return measured < 24.5 ? 24 : (measured < 27.5 ? 25 : 30);
+            }
+        };
+        
+        // appends CaptureEntries to a binary log, see CaptureLogFormat.
+        // push() is lock-free and never allocates, so it can be called from the
+        // audio thread (e.g. Receiver::onFrame and onBuffer). a writer thread encodes the frames,
+        // starts a new file when one grows past max_file_size and makes a sync
+        // point every sync_frames frames, after which the file is fsync'ed.
+        // what is queued is handed to the OS whenever the writer runs idle.
+        // does not depend on openFrameworks.
+        class CaptureLogWriter {
+        public:
+            struct Settings {
+                std::string prefix{"capture"}; // files are prefix-000000.ltclog, prefix-000001.ltclog, ...
+                double sample_rate{48000.0};
+                int fps{0}; // for predicting the LTC word, 0: guessed from the first frame
+                std::uint64_t max_file_size{64ull << 20};
+                std::size_t sync_frames{250};
+                std::size_t queue_size{4096};
+            };
+            
+            CaptureLogWriter() = default;
+            CaptureLogWriter(const CaptureLogWriter &) = delete;
+            CaptureLogWriter &operator=(const CaptureLogWriter &) = delete;
+            ~CaptureLogWriter()
+            { close(); };
+            
+            bool open(const Settings &settings) {
+                close();
+                this->settings = settings;
+                queue.reset(new SpscQueue<CaptureEntry>(settings.queue_size));
+                file_index = 0;
+                fps = settings.fps;
+                if(!openFile()) return false;
+                running = true;
+                writer = std::thread([this] { work(); });
+                return true;
+            }
+            
+            // writes what is queued, a last sync point and closes the file
+            void close() {
+                if(!writer.joinable()) return;
+                running = false;
+                writer.join();
+            }
+            
+            bool isOpen() const
+            { return writer.joinable(); };
+            
+            // from the producer thread only. false if the queue was full and the frame dropped.
+            bool push(const CaptureEntry &entry) {
+                if(queue && queue->push(entry)) return true;
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            
+            bool push(const LTCFrameExt &frame, bool extrapolated, double time)
+            { return push(CaptureEntry::make(frame, extrapolated, time)); };
+            
+            // a sound buffer, so a Replay can reproduce buffer sizes and timing
+            bool pushBuffer(std::int64_t position, std::size_t frames, double arrival)
+            { return push(CaptureEntry::makeBuffer(position, frames, arrival)); };
+            
+            std::uint64_t getDropped() const
+            { return dropped.load(); };
+            
+            std::uint64_t getWritten() const
+            { return written.load(); };
+            
+            std::string getPath(std::size_t index) const {
+                char suffix[32];
+                std::snprintf(suffix, sizeof(suffix), "-%06zu.ltclog", index);
+                return settings.prefix + suffix;
+            }
+            
+        protected:
+            using Format = CaptureLogFormat;
+            
+            bool openFile() {
+                file = std::fopen(getPath(file_index).c_str(), "wb");
+                if(!file) return false;
+                out.clear();
+                out.insert(out.end(), {'L', 'T', 'C', 'L'});
+                Format::put(out, 1, 4);
+                std::uint64_t rate;
+                std::memcpy(&rate, &settings.sample_rate, sizeof(rate));
+                Format::put(out, rate, 8);
+                file_size = 0;
+                synced = false;
+                segment_crc = 0;
+                return true;
+            }
+            
+            void closeFile() {
+                if(!file) return;
+                if(synced) writeSync(CaptureEntry{}, true);
+                flush(true);
+                std::fclose(file);
+                file = nullptr;
+            }
+            
+            void flush(bool sync) {
+                if(!file) return;
+                if(!out.empty()) {
+                    std::fwrite(out.data(), 1, out.size(), file);
+                    file_size += out.size();
+                    out.clear();
+                }
+                std::fflush(file);
+                if(sync) {
+#ifdef _WIN32
+                    _commit(_fileno(file));
+#else
+                    fsync(fileno(file));
+#endif
+                }
+            }
+            
+            void work() {
+                CaptureEntry entry;
+                while(true) {
+                    const bool stopping = !running.load();
+                    bool any = false;
+                    while(queue->pop(entry)) {
+                        write(entry);
+                        any = true;
+                    }
+                    if(stopping) break;
+                    if(!any) {
+                        flush(false);
+                        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    }
+                }
+                closeFile();
+            }
+            
+            void write(const CaptureEntry &entry) {
+                if(settings.max_file_size <= file_size + out.size()) {
+                    closeFile();
+                    ++file_index;
+                    if(!openFile()) {
+                        dropped.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
+                }
+                if(fps <= 0 && !entry.buffer) fps = Format::guessFps(entry, settings.sample_rate);
+                const std::uint64_t lost = dropped.load(std::memory_order_relaxed);
+                if(!synced || settings.sync_frames <= since_sync + 1 || lost != dropped_at_sync
+                   || (!entry.buffer && !has_previous))
+                {
+                    writeSync(entry);
+                } else if(entry.buffer) {
+                    writeBuffer(entry);
+                } else {
+                    writeDelta(entry);
+                }
+                if(64 * 1024 <= out.size()) flush(false);
+                written.fetch_add(1, std::memory_order_relaxed);
+            }
+            
+            void writeSync(const CaptureEntry &entry, bool end = false) {
+                const std::size_t start = out.size();
+                out.push_back(Format::Sync);
+                out.insert(out.end(), {'S', 'Y', 'N', 'C'});
+                Format::put(out, static_cast<std::uint64_t>(fps), 1);
+                Format::put(out, static_cast<std::uint64_t>(entry.off_start), 8);
+                Format::put(out, static_cast<std::uint64_t>(entry.off_end), 8);
+                out.insert(out.end(), entry.ltc, entry.ltc + sizeof(entry.ltc));
+                Format::put(out, (entry.reverse ? Format::Reverse : 0) | (entry.extrapolated ? Format::Extrapolated : 0)
+                            | (entry.buffer ? Format::Buffer : 0) | (end ? Format::End : 0), 1);
+                Format::put(out, static_cast<std::uint64_t>(Format::centiDecibel(entry.volume)), 2);
+                std::uint64_t time;
+                std::memcpy(&time, &entry.time, sizeof(time));
+                Format::put(out, time, 8);
+                const auto wall = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch());
+                Format::put(out, static_cast<std::uint64_t>(wall.count()), 8);
+                const std::uint64_t lost = dropped.load(std::memory_order_relaxed);
+                Format::put(out, lost - dropped_at_sync, 4);
+                Format::put(out, segment_crc, 4);
+                Format::put(out, Format::crc32(out.data() + start, out.size() - start), 4);
+                dropped_at_sync = lost;
+                segment_crc = Format::crc32(out.data() + start, out.size() - start);
+                
+                previous = entry;
+                previous.volume = static_cast<float>(Format::centiDecibel(entry.volume) / 100.0);
+                has_previous = !entry.buffer;
+                buffer_end = entry.off_end + 1;
+                buffer_time = entry.time;
+                synced = true;
+                since_sync = 0;
+                flush(true);
+            }
+            
+            void writeDelta(const CaptureEntry &entry) {
+                unsigned char predicted[sizeof(entry.ltc)];
+                Format::predictWord(previous.ltc, entry.reverse, fps, predicted);
+                const std::int64_t volume = Format::centiDecibel(entry.volume);
+                const std::int64_t previous_volume = Format::centiDecibel(previous.volume);
+                const double expected = Format::predictTime(previous, entry.off_end, settings.sample_rate);
+                const std::int64_t residual = std::llround((entry.time - expected) * 1e6);
+                
+                std::uint8_t tag = 0;
+                if(!std::memcmp(predicted, entry.ltc, sizeof(predicted))) tag |= Format::PredictedWord;
+                if(entry.reverse) tag |= Format::Reverse;
+                if(entry.extrapolated) tag |= Format::Extrapolated;
+                if(volume == previous_volume) tag |= Format::SameVolume;
+                if(residual == 0) tag |= Format::PredictedTime;
+                const std::size_t start = out.size();
+                out.push_back(tag);
+                Format::putVarint(out, entry.off_start - previous.off_end - 1);
+                Format::putVarint(out, (entry.off_end - entry.off_start) - (previous.off_end - previous.off_start));
+                if(!(tag & Format::PredictedWord)) out.insert(out.end(), entry.ltc, entry.ltc + sizeof(entry.ltc));
+                if(!(tag & Format::SameVolume)) Format::putVarint(out, volume - previous_volume);
+                if(!(tag & Format::PredictedTime)) Format::putVarint(out, residual);
+                segment_crc = Format::crc32(out.data() + start, out.size() - start, segment_crc);
+                
+                // what the reader will reconstruct
+                const double time = expected + residual * 1e-6;
+                previous = entry;
+                previous.volume = static_cast<float>(volume / 100.0);
+                previous.time = time;
+                ++since_sync;
+            }
+            
+            void writeBuffer(const CaptureEntry &entry) {
+                const double expected = Format::predictArrival(buffer_end, buffer_time, entry.off_end + 1, settings.sample_rate);
+                const std::int64_t residual = std::llround((entry.time - expected) * 1e6);
+                const std::size_t start = out.size();
+                out.push_back(Format::Buffer | (residual == 0 ? Format::PredictedTime : 0));
+                Format::putVarint(out, entry.off_start - buffer_end);
+                Format::putVarint(out, entry.off_end - entry.off_start + 1);
+                if(residual) Format::putVarint(out, residual);
+                segment_crc = Format::crc32(out.data() + start, out.size() - start, segment_crc);
+                
+                buffer_end = entry.off_end + 1;
+                buffer_time = expected + residual * 1e-6;
+                ++since_sync;
+            }
+            
+            Settings settings;
+            std::unique_ptr<SpscQueue<CaptureEntry>> queue;
+            std::thread writer;
+            std::atomic<bool> running{false};
+            std::atomic<std::uint64_t> dropped{0};
+            std::atomic<std::uint64_t> written{0};
+            
+            // writer thread only
+            std::FILE *file{nullptr};
+            std::size_t file_index{0};
+            std::uint64_t file_size{0};
+            std::vector<unsigned char> out;
+            CaptureEntry previous;
+            bool has_previous{false}; // a frame since the last sync record
+            std::int64_t buffer_end{0}; // of the last buffer or sync record
+            double buffer_time{0.0};
+            bool synced{false}; // anything in this file yet
+            std::size_t since_sync{0};
+            std::uint64_t dropped_at_sync{0};
+            std::uint32_t segment_crc{0};
+            int fps{0};
+        };
+        
+        // reads a log written by CaptureLogWriter. frames are handed out a
+        // segment at a time once the sync record after it vouches for it, a
+        // damaged segment is skipped as a whole. a file cut off by a crash
+        // yields everything up to the last complete record.
+        class CaptureLogReader {
+        public:
+            bool open(const std::string &path) {
+                data.clear();
+                pending.clear();
+                ready = 0;
+                pos = 0;
+                skipped = 0;
+                dropped = 0;
+                std::FILE *file = std::fopen(path.c_str(), "rb");
+                if(!file) return false;
+                unsigned char block[1 << 16];
+                for(std::size_t n; (n = std::fread(block, 1, sizeof(block), file)) != 0;) {
+                    data.insert(data.end(), block, block + n);
+                }
+                std::fclose(file);
+                if(data.size() < Format::header_size || std::memcmp(data.data(), "LTCL", 4) || Format::get(data.data() + 4, 4) != 1) {
+                    data.clear();
+                    return false;
+                }
+                const std::uint64_t rate = Format::get(data.data() + 8, 8);
+                std::memcpy(&sample_rate, &rate, sizeof(sample_rate));
+                pos = Format::header_size;
+                return true;
+            }
+            
+            // false at the end of the file
+            bool next(CaptureEntry &entry) {
+                while(ready == pending.size()) {
+                    if(!fill()) return false;
+                }
+                entry = pending[ready++];
+                return true;
+            }
+            
+            double getSampleRate() const
+            { return sample_rate; };
+            
+            // frames the writer had to drop, as reported by the sync records so far
+            std::uint64_t getDropped() const
+            { return dropped; };
+            
+            // wall clock of the last sync record, us since 1970
+            std::uint64_t getWallClock() const
+            { return wall_clock; };
+            
+            // bytes of damaged records passed over
+            std::size_t getSkipped() const
+            { return skipped; };
+            
+        protected:
+            using Format = CaptureLogFormat;
+            
+            struct Sync {
+                CaptureEntry entry;
+                bool end;
+                int fps;
+                std::uint32_t segment_crc;
+                std::uint64_t wall_clock;
+                std::uint64_t dropped;
+            };
+            
+            // decodes the next segment, a sync record and the deltas after it.
+            // false at the end of the file.
+            bool fill() {
+                pending.clear();
+                ready = 0;
+                while(pos < data.size()) {
+                    const std::size_t start = pos;
+                    Sync sync;
+                    if(readSync(pos, sync)) {
+                        pos += Format::sync_size;
+                        dropped += sync.dropped;
+                        wall_clock = sync.wall_clock;
+                        if(sync.end) continue;
+                        fps = sync.fps;
+                        pending.push_back(sync.entry);
+                        previous = sync.entry;
+                        has_previous = !sync.entry.buffer;
+                        buffer_end = sync.entry.off_end + 1;
+                        buffer_time = sync.entry.time;
+                        bool cut_off = false;
+                        while(pos < data.size() && data[pos] != Format::Sync) {
+                            CaptureEntry entry;
+                            if(!readDelta(entry, cut_off)) break;
+                            pending.push_back(entry);
+                        }
+                        // the tail of a file that wasn't closed
+                        if(pos == data.size() || cut_off || data.size() < pos + Format::sync_size) {
+                            pos = data.size();
+                            return true;
+                        }
+                        Sync after;
+                        if(data[pos] == Format::Sync && readSync(pos, after)
+                           && after.segment_crc == Format::crc32(data.data() + start, pos - start))
+                        {
+                            return true;
+                        }
+                        pending.clear();
+                    }
+                    // lost track, look for the next sync record
+                    pos = start + 1;
+                    while(pos < data.size() && data[pos] != Format::Sync) ++pos;
+                    skipped += pos - start;
+                }
+                return false;
+            }
+            
+            bool readSync(std::size_t at, Sync &sync) const {
+                if(data.size() < at + Format::sync_size) return false;
+                const unsigned char *p = data.data() + at;
+                if(p[0] != Format::Sync || std::memcmp(p + 1, "SYNC", 4)) return false;
+                if(Format::crc32(p, Format::sync_size - 4) != Format::get(p + Format::sync_size - 4, 4)) return false;
+                CaptureEntry &entry = sync.entry;
+                sync.fps = static_cast<int>(p[5]);
+                entry.off_start = static_cast<std::int64_t>(Format::get(p + 6, 8));
+                entry.off_end = static_cast<std::int64_t>(Format::get(p + 14, 8));
+                std::memcpy(entry.ltc, p + 22, sizeof(entry.ltc));
+                entry.reverse = (p[32] & Format::Reverse) != 0;
+                entry.extrapolated = (p[32] & Format::Extrapolated) != 0;
+                entry.buffer = (p[32] & Format::Buffer) != 0;
+                sync.end = (p[32] & Format::End) != 0;
+                entry.volume = static_cast<float>(static_cast<std::int16_t>(Format::get(p + 33, 2)) / 100.0);
+                const std::uint64_t time = Format::get(p + 35, 8);
+                std::memcpy(&entry.time, &time, sizeof(entry.time));
+                sync.wall_clock = Format::get(p + 43, 8);
+                sync.dropped = Format::get(p + 51, 4);
+                sync.segment_crc = static_cast<std::uint32_t>(Format::get(p + 55, 4));
+                return true;
+            }
+            
+            // `cut_off` if the record runs past the end of the file
+            bool readDelta(CaptureEntry &entry, bool &cut_off) {
+                const unsigned char *p = data.data() + pos;
+                const unsigned char *end = data.data() + data.size();
+                const std::uint8_t tag = *p++;
+                if(0x80 <= tag) return false;
+                cut_off = true;
+                std::int64_t gap, length, volume = 0, residual = 0;
+                if(tag & Format::Buffer) {
+                    if(!Format::getVarint(p, end, gap) || !Format::getVarint(p, end, length)) return false;
+                    if(!(tag & Format::PredictedTime) && !Format::getVarint(p, end, residual)) return false;
+                    cut_off = false;
+                    entry = CaptureEntry::makeBuffer(buffer_end + gap, static_cast<std::size_t>(length), 0.0);
+                    entry.time = Format::predictArrival(buffer_end, buffer_time, entry.off_end + 1, sample_rate) + residual * 1e-6;
+                    buffer_end = entry.off_end + 1;
+                    buffer_time = entry.time;
+                    pos = p - data.data();
+                    return true;
+                }
+                if(!has_previous) return false;
+                if(!Format::getVarint(p, end, gap) || !Format::getVarint(p, end, length)) return false;
+                entry.off_start = previous.off_end + 1 + gap;
+                entry.off_end = entry.off_start + (previous.off_end - previous.off_start) + length;
+                entry.reverse = (tag & Format::Reverse) != 0;
+                entry.extrapolated = (tag & Format::Extrapolated) != 0;
+                entry.buffer = false;
+                if(tag & Format::PredictedWord) {
+                    Format::predictWord(previous.ltc, entry.reverse, fps, entry.ltc);
+                } else {
+                    if(end - p < static_cast<std::ptrdiff_t>(sizeof(entry.ltc))) return false;
+                    std::memcpy(entry.ltc, p, sizeof(entry.ltc));
+                    p += sizeof(entry.ltc);
+                }
+                if(!(tag & Format::SameVolume) && !Format::getVarint(p, end, volume)) return false;
+                if(!(tag & Format::PredictedTime) && !Format::getVarint(p, end, residual)) return false;
+                cut_off = false;
+                entry.volume = static_cast<float>((Format::centiDecibel(previous.volume) + volume) / 100.0);
+                entry.time = Format::predictTime(previous, entry.off_end, sample_rate) + residual * 1e-6;
+                previous = entry;
+                pos = p - data.data();
+                return true;
+            }
+            
+            std::vector<unsigned char> data;
+            std::size_t pos{0};
+            std::vector<CaptureEntry> pending; // the current segment
+            std::size_t ready{0}; // of which handed out
+            double sample_rate{0.0};
+            int fps{0};
+            CaptureEntry previous; // the last frame
+            bool has_previous{false};
+            std::int64_t buffer_end{0};
+            double buffer_time{0.0};
+            std::uint64_t dropped{0};
+            std::uint64_t wall_clock{0};
+            std::size_t skipped{0};
+        };
+    };
+};
+
+#endif /* ofxLTC_CaptureLog_h */
@@ -0,0 +1,137 @@
+//
+//  Clock.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_Clock_h
+#define ofxLTC_Clock_h
+
+#include "SeqLock.h"
+#include "FrameCount.h"
+
+#include <cmath>
+#include <cstdint>
+
+namespace ofx {
+    namespace LTC {
+        // continuous timecode clock. a second order delay-locked loop is fed with
+        // the time each decoded frame started and interpolates between them,
+        // so timeAt() gives a fractional frame count for any instant.
+        // update() is called from one thread (the audio thread),
+        // timeAt() is lock-free and may be called from any thread.
+        class Clock {
+        public:
+            // loop bandwidth in Hz. lower is smoother, higher follows varispeed faster.
+            void setBandwidth(double hz)
+            { bandwidth = hz; };
+            
+            void reset() {
+                running = false;
+                published.store(State{});
+            }
+            
+            // frame_count: frames since 00:00:00:00 (see toFrameCount)
+            // time: monotonic time at which this frame's position was reached
+            void update(std::int64_t frame_count, double time,
+                        int fps, bool drop_frame, bool reverse)
+            {
+                const int direction = reverse ? -1 : 1;
+                const std::int64_t per_day = framesPerDay(fps, drop_frame);
+                
+                bool continuous = running
+                               && direction == last_direction
+                               && per_day == frames_per_day
+                               && time - t1 < 4.0 * e2;
+                if(continuous) {
+                    std::int64_t step = (frame_count - last_count) % per_day;
+                    if(step < 0) step += per_day;
+                    if(step == per_day - 1) step = -1;
+                    continuous = (step == direction);
+                }
+                
+                if(continuous) {
+                    // DLL, see F. Adriaensen "Using a DLL to filter time"
+                    const double omega = 2.0 * 3.14159265358979323846 * bandwidth * e2;
+                    const double b = std::sqrt(2.0) * omega;
+                    const double c = omega * omega;
+                    const double e = time - t1;
+                    t0 = t1;
+                    t1 += b * e + e2;
+                    e2 += c * e;
+                    frames += direction;
+                } else {
+                    // discontinuity: locate, jump, direction change or first frame
+                    e2 = 1.0 / fps;
+                    t0 = time;
+                    t1 = time + e2;
+                    frames = static_cast<double>(frame_count);
+                    running = true;
+                }
+                last_count = frame_count;
+                last_direction = direction;
+                frames_per_day = per_day;
+                
+                State state;
+                state.time = t0;
+                state.frames = frames;
+                state.rate = direction / (t1 - t0);
+                state.frames_per_day = static_cast<double>(per_day);
+                state.valid = true;
+                published.store(state);
+            }
+            
+            // stop advancing, e.g. when the signal is lost
+            void hold(double time) {
+                State state = published.load();
+                if(!state.valid) return;
+                state.frames = unwrapped(state, time);
+                state.time = time;
+                state.rate = 0.0;
+                published.store(state);
+                running = false;
+            }
+            
+            // fractional frames since 00:00:00:00 at the given monotonic time,
+            // or a negative value if the clock has not seen a frame yet.
+            double timeAt(double time) const {
+                const State state = published.load();
+                if(!state.valid) return -1.0;
+                double position = std::fmod(unwrapped(state, time), state.frames_per_day);
+                if(position < 0.0) position += state.frames_per_day;
+                return position;
+            }
+            
+            // frames per second, negative when running in reverse
+            double getRate() const
+            { return published.load().rate; };
+            
+            bool isValid() const
+            { return published.load().valid; };
+            
+        private:
+            struct State {
+                double time{0.0};
+                double frames{0.0};
+                double rate{0.0};
+                double frames_per_day{1.0};
+                bool valid{false};
+            };
+            
+            static double unwrapped(const State &state, double time)
+            { return state.frames + state.rate * (time - state.time); };
+            
+            SeqLock<State> published;
+            double bandwidth{1.0};
+            
+            // writer side only
+            bool running{false};
+            double t0{0.0}, t1{0.0}, e2{0.0};
+            double frames{0.0};
+            std::int64_t last_count{0};
+            std::int64_t frames_per_day{0};
+            int last_direction{1};
+        };
+    };
+};
+
+#endif /* ofxLTC_Clock_h */
@@ -0,0 +1,193 @@
+//
+//  EncoderStream.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_EncoderStream_h
+#define ofxLTC_EncoderStream_h
+
+#include "ltc.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace ofx {
+    namespace LTC {
+        // one LTC signal encoded straight into float sample buffers, a frame
+        // at a time across calls of any size. moving on to the next frame is
+        // an ltc_encoder_inc_timecode, the full timecode conversion only runs
+        // to locate. no openFrameworks and no allocation once set up; one
+        // thread renders, setVolume may be called from any.
+        class EncoderStream {
+        public:
+            EncoderStream() = default;
+            EncoderStream(const EncoderStream &) = delete;
+            EncoderStream &operator=(const EncoderStream &) = delete;
+            
+            ~EncoderStream()
+            { close(); };
+            
+            bool setup(double sample_rate, double fps, enum LTC_TV_STANDARD standard = LTC_TV_525_60, int flags = LTC_USE_DATE) {
+                close();
+                encoder = ltc_encoder_create(sample_rate, fps, standard, flags);
+                if(!encoder) return false;
+                this->sample_rate = sample_rate;
+                this->fps = fps;
+                this->standard = standard;
+                this->flags = flags;
+                if(ltc_encoder_set_format(encoder, LTC_SAMPLE_FLOAT) != 0) {
+                    close();
+                    return false;
+                }
+                applied_volume = volume;
+                ltc_encoder_set_volume(encoder, applied_volume);
+                has_shown = false;
+                return true;
+            }
+            
+            void close() {
+                if(encoder) ltc_encoder_free(encoder);
+                encoder = nullptr;
+            }
+            
+            bool isSetup() const
+            { return encoder != nullptr; };
+            
+            // level in dBFS (<= 0), applied from the next render on
+            void setVolume(double dBFS)
+            { if(dBFS <= 0.0) volume = dBFS; };
+            
+            double getVolume() const
+            { return volume; };
+            
+            double getSampleRate() const
+            { return sample_rate; };
+            
+            double getFps() const
+            { return fps; };
+            
+            int getFlags() const
+            { return flags; };
+            
+            LTCEncoder *getEncoder() const
+            { return encoder; };
+            
+            LTCFrame getFrame() const {
+                LTCFrame frame;
+                ltc_encoder_get_frame(encoder, &frame);
+                return frame;
+            }
+            
+            // sets the frame to time, converting it in full
+            void locate(const SMPTETimecode &time, bool drop_frame) {
+                LTCFrame frame;
+                ltc_encoder_get_frame(encoder, &frame);
+                frame.dfbit = drop_frame ? 1 : 0;
+                SMPTETimecode t = time;
+                ltc_time_to_frame(&frame, &t, standard, flags);
+                ltc_encoder_set_frame(encoder, &frame);
+                shown = time;
+                shown_drop_frame = drop_frame;
+                has_shown = true;
+            }
+            
+            // makes the frame show time, the same as locate: nothing if it
+            // already does, one increment if time is the frame after it.
+            void show(const SMPTETimecode &time, bool drop_frame) {
+                if(has_shown && drop_frame == shown_drop_frame && sameDate(time, shown)) {
+                    if(sameTime(time, shown)) return;
+                    // drop-frame labels skip frames 0 and 1 of most minutes
+                    const bool skipped = drop_frame && time.secs == 0 && time.frame < 2 && time.mins % 10 != 0;
+                    if(!skipped && frameIndex(time) == frameIndex(shown) + 1) {
+                        ltc_encoder_inc_timecode(encoder);
+                        shown = time;
+                        return;
+                    }
+                }
+                locate(time, drop_frame);
+            }
+            
+            // the next frame, without knowing its time
+            void advance() {
+                ltc_encoder_inc_timecode(encoder);
+                has_shown = false;
+            }
+            
+            // the next sample starts a new frame
+            void restart()
+            { ltc_encoder_reset(encoder); };
+            
+            // the next sample starts a new frame, as long as frame `index` of
+            // a stream that started with restart() and the frames after it.
+            // false without an exact rate, see getFrameLength.
+            bool restart(long long index) {
+                ltc_encoder_reset(encoder);
+                return ltc_encoder_set_phase(encoder, index) == 0;
+            }
+            
+            // samples per frame as the fraction num / den; frame k after a
+            // restart() starts at sample floor(k * num / den + 0.5).
+            // false if the sample rate or fps has no exact fraction.
+            bool getFrameLength(long long &num, long long &den) const
+            { return ltc_encoder_get_frame_length(encoder, &num, &den) == 0; };
+            
+            // samples the current frame takes, at its start
+            int getFrameSamples() const
+            { return ltc_encoder_get_frame_samples(encoder); };
+            
+            bool atFrameStart() const
+            { return ltc_encoder_get_frame_position(encoder) == 0; };
+            
+            // frames samples into every stride'th float of out. on_start(i) is
+            // called before sample i when it starts a frame, to set that frame.
+            template <typename OnStart>
+            int render(float *out, int frames, int stride, OnStart &&on_start) {
+                applyVolume();
+                int i = 0;
+                while(i < frames) {
+                    if(atFrameStart()) on_start(i);
+                    const int written = ltc_encoder_encode_samples(encoder, out + static_cast<std::size_t>(i) * stride, frames - i, stride);
+                    if(written <= 0) break;
+                    i += written;
+                }
+                return i;
+            }
+            
+        protected:
+            void applyVolume() {
+                const double v = volume;
+                if(v == applied_volume) return;
+                applied_volume = v;
+                ltc_encoder_set_volume(encoder, applied_volume);
+            }
+            
+            long frameIndex(const SMPTETimecode &t) const {
+                const long rate = std::lrint(fps);
+                return ((t.hours * 60L + t.mins) * 60L + t.secs) * rate + t.frame;
+            }
+            
+            static bool sameTime(const SMPTETimecode &a, const SMPTETimecode &b)
+            { return a.hours == b.hours && a.mins == b.mins && a.secs == b.secs && a.frame == b.frame; };
+            
+            static bool sameDate(const SMPTETimecode &a, const SMPTETimecode &b) {
+                return a.years == b.years && a.months == b.months && a.days == b.days
+                    && std::strncmp(a.timezone, b.timezone, sizeof(a.timezone)) == 0;
+            }
+            
+            LTCEncoder *encoder{nullptr};
+            double sample_rate{0.0};
+            double fps{0.0};
+            enum LTC_TV_STANDARD standard{LTC_TV_525_60};
+            int flags{0};
+            std::atomic<double> volume{-3.0}; // dBFS
+            double applied_volume{-3.0};
+            
+            SMPTETimecode shown; // what the frame was last set to
+            bool shown_drop_frame{false};
+            bool has_shown{false};
+        };
+    };
+};
+
+#endif /* ofxLTC_EncoderStream_h */
@@ -0,0 +1,58 @@
+//
+//  FrameCount.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_FrameCount_h
+#define ofxLTC_FrameCount_h
+
+#include "ltc.h"
+
+#include <cstdint>
+
+namespace ofx {
+    namespace LTC {
+        // number of timecode labels in 24 hours. drop-frame only applies to 30 fps.
+        inline std::int64_t framesPerDay(int fps, bool drop_frame) {
+            if(drop_frame && fps == 30) return 24 * 107892;
+            return 24ll * 60 * 60 * fps;
+        }
+        
+        // frames since 00:00:00:00, skipping the labels drop-frame timecode leaves out
+        inline std::int64_t toFrameCount(int hour, int min, int sec, int frame,
+                                         int fps, bool drop_frame)
+        {
+            const std::int64_t minutes = hour * 60ll + min;
+            std::int64_t count = (minutes * 60 + sec) * fps + frame;
+            if(drop_frame && fps == 30) count -= 2 * (minutes - minutes / 10);
+            return count;
+        }
+        
+        // the label of a frame count, the inverse of toFrameCount()
+        inline void fromFrameCount(std::int64_t count, int fps, bool drop_frame,
+                                   int &hour, int &min, int &sec, int &frame)
+        {
+            if(drop_frame && fps == 30) {
+                const std::int64_t tens = count / 17982;
+                const std::int64_t rest = count % 17982;
+                count += 18 * tens + (rest < 2 ? 0 : 2 * ((rest - 2) / 1798));
+            }
+            frame = static_cast<int>(count % fps);
+            count /= fps;
+            sec = static_cast<int>(count % 60);
+            count /= 60;
+            min = static_cast<int>(count % 60);
+            hour = static_cast<int>(count / 60);
+        }
+        
+        inline std::int64_t toFrameCount(const LTCFrame &f, int fps) {
+            return toFrameCount(f.hours_tens * 10 + f.hours_units,
+                                f.mins_tens * 10 + f.mins_units,
+                                f.secs_tens * 10 + f.secs_units,
+                                f.frame_tens * 10 + f.frame_units,
+                                fps, f.dfbit != 0);
+        }
+    };
+};
+
+#endif /* ofxLTC_FrameCount_h */
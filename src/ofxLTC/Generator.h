@@ -0,0 +1,275 @@
+//
+//  Generator.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_Generator_h
+#define ofxLTC_Generator_h
+
+#include "EncoderStream.h"
+#include "FrameCount.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace ofx {
+    namespace LTC {
+        // any number of LTC streams, each with its own fps, standard, flags and
+        // output channels, rendered by one audio callback from one timeline.
+        // the timeline is the time of day in samples and only moves with the
+        // samples rendered. frame k of a stream starts at timeline sample
+        // floor(k * sample_rate / fps + 0.5), exactly, for as long as it runs,
+        // so streams of every rate stay phase-aligned to the same clock.
+        // each callback encodes every stream over the whole buffer in one go,
+        // then adds it to its channels. no openFrameworks: call render from
+        // the audioOut of the sound stream.
+        class Generator {
+        public:
+            struct StreamSettings {
+                double fps{25.0}; // 23.976, 29.97, 59.94 count frames at n * 1000 / 1001
+                bool drop_frame{false}; // only at 29.97
+                enum LTC_TV_STANDARD standard{LTC_TV_625_50};
+                int flags{0}; // with LTC_USE_DATE the user bits carry the date, see setDate
+                std::uint64_t channels{1}; // output channel mask, bit c for channel c
+                double volume{-3.0}; // dBFS
+            };
+            
+            // drops all streams. render() calls up to max_buffer_size frames don't allocate
+            void setup(double sample_rate, std::size_t max_buffer_size = 4096) {
+                this->sample_rate = sample_rate;
+                streams.clear();
+                scratch.assign(max_buffer_size, 0.0f);
+                timeline = 0;
+                position = 0;
+                locate_time = 0.0;
+                locate_request = 0;
+                applied_locate = 0;
+                playing = false;
+                was_playing = false;
+            }
+            
+            // not while render runs. the index of the stream, -1 if its encoder can't be created
+            int addStream(const StreamSettings &settings) {
+                std::unique_ptr<Stream> stream(new Stream);
+                stream->settings = settings;
+                stream->rate = static_cast<int>(std::lrint(settings.fps));
+                stream->drop_frame = settings.drop_frame && stream->rate == 30;
+                stream->encoder.setVolume(settings.volume);
+                if(!stream->encoder.setup(sample_rate, settings.fps, settings.standard, settings.flags)) return -1;
+                if(!stream->encoder.getFrameLength(stream->frame_num, stream->frame_den)) {
+                    stream->frame_num = 0;
+                    stream->frame_den = 0;
+                }
+                streams.push_back(std::move(stream));
+                return static_cast<int>(streams.size()) - 1;
+            }
+            
+            // not while render runs. the date at timeline 0, 1970-01-01 +0000
+            // by default; frames past midnight carry the days after it.
+            void setDate(int year, int month, int day, const char *timezone = "+0000") {
+                date = daysFromCivil(year, month, day);
+                std::memset(this->timezone, 0, sizeof(this->timezone));
+                std::strncpy(this->timezone, timezone, sizeof(this->timezone) - 1);
+            }
+            
+            std::size_t getNumStreams() const
+            { return streams.size(); };
+            
+            const StreamSettings &getStreamSettings(std::size_t stream) const
+            { return streams[stream]->settings; };
+            
+            // from any thread, applied from the next render on
+            void setVolume(std::size_t stream, double dBFS)
+            { streams[stream]->encoder.setVolume(dBFS); };
+            
+            double getSampleRate() const
+            { return sample_rate; };
+            
+            // transport, from any thread. takes effect at the start of the next render.
+            // seconds since midnight; every stream starts with its next whole frame.
+            void locate(double seconds) {
+                locate_time = seconds;
+                locate_request.fetch_add(1, std::memory_order_release);
+            }
+            
+            void start()
+            { playing = true; };
+            
+            // silences all streams, the timeline stays where it is
+            void stop()
+            { playing = false; };
+            
+            bool isPlaying() const
+            { return playing; };
+            
+            // timeline time of the next sample rendered, in seconds since midnight
+            double getTime() const
+            { return timeline / sample_rate; };
+            
+            // samples rendered so far
+            std::int64_t getPosition() const
+            { return position; };
+            
+            // on the audio thread, for every frame that starts: the stream,
+            // the position of its first sample and the frame
+            void onFrame(const std::function<void(std::size_t, std::int64_t, const LTCFrame &)> &callback)
+            { frame_callback = callback; };
+            
+            // frames interleaved sample frames of num_channels floats. the
+            // generator owns the buffer: channels no stream uses are silent,
+            // streams sharing a channel add up.
+            void render(float *out, std::size_t frames, std::size_t num_channels) {
+                std::fill(out, out + frames * num_channels, 0.0f);
+                applyTransport();
+                if(scratch.size() < frames) scratch.resize(frames);
+                const std::uint64_t all = num_channels < 64 ? (std::uint64_t(1) << num_channels) - 1 : ~std::uint64_t(0);
+                
+                for(std::size_t index = 0; index < streams.size(); ++index) {
+                    Stream &stream = *streams[index];
+                    const std::uint64_t mask = stream.settings.channels & all;
+                    if(!was_playing || !renderStream(index, stream, frames)) continue;
+                    for(std::size_t c = 0; c < num_channels; ++c) {
+                        if(!(mask >> c & 1)) continue;
+                        float *channel = out + c;
+                        for(std::size_t j = 0; j < frames; ++j) channel[j * num_channels] += scratch[j];
+                    }
+                }
+                
+                if(was_playing) timeline += static_cast<std::int64_t>(frames);
+                position += static_cast<std::int64_t>(frames);
+            }
+            
+        protected:
+            struct Stream {
+                EncoderStream encoder;
+                StreamSettings settings;
+                int rate{25}; // frames per second of the labels
+                bool drop_frame{false};
+                bool aligned{false}; // encoding frame `next` onwards
+                std::int64_t next{0}; // frames since midnight of the next frame to start
+                long long frame_num{0}, frame_den{0}; // exact samples per frame, 0 / 0 if none
+            };
+            
+            // timeline sample where frame k of the stream starts
+            std::int64_t frameStart(const Stream &stream, std::int64_t k) const {
+                if(!stream.frame_den) {
+                    return static_cast<std::int64_t>(std::floor(k * sample_rate / stream.encoder.getFps() + 0.5));
+                }
+                // floor(k * num / den + 0.5), in parts that don't overflow
+                const long long num = stream.frame_num, den = stream.frame_den;
+                const long long q = k / den, r = k % den;
+                return q * num + (2 * r * num + den) / (2 * den);
+            }
+            
+            // the first frame of the stream that starts at or after the timeline
+            std::int64_t firstFrame(const Stream &stream) const {
+                std::int64_t k = static_cast<std::int64_t>(timeline * stream.encoder.getFps() / sample_rate);
+                while(0 < k && timeline <= frameStart(stream, k - 1)) --k;
+                while(frameStart(stream, k) < timeline) ++k;
+                return k;
+            }
+            
+            void applyTransport() {
+                const std::uint32_t request = locate_request.load(std::memory_order_acquire);
+                const bool play = playing;
+                bool realign = play && !was_playing;
+                if(request != applied_locate) {
+                    applied_locate = request;
+                    timeline = static_cast<std::int64_t>(std::llround(locate_time.load() * sample_rate));
+                    realign = true;
+                }
+                was_playing = play;
+                if(realign) {
+                    for(auto &stream : streams) stream->aligned = false;
+                }
+            }
+            
+            // the callback's samples of one stream into scratch, false if all silent
+            bool renderStream(std::size_t index, Stream &stream, std::size_t frames) {
+                std::size_t i = 0;
+                if(!stream.aligned) {
+                    const std::int64_t k = firstFrame(stream);
+                    const std::int64_t gap = frameStart(stream, k) - timeline;
+                    if(static_cast<std::int64_t>(frames) <= gap) return false;
+                    std::fill(scratch.begin(), scratch.begin() + gap, 0.0f);
+                    i = static_cast<std::size_t>(gap);
+                    stream.next = k;
+                    // the frames that follow k keep to the timeline too
+                    if(!stream.encoder.restart(k)) stream.encoder.restart();
+                    stream.aligned = true;
+                }
+                const std::int64_t from = position + static_cast<std::int64_t>(i);
+                stream.encoder.render(scratch.data() + i, static_cast<int>(frames - i), 1, [&](int j) {
+                    SMPTETimecode time;
+                    std::memset(&time, 0, sizeof(time));
+                    const std::int64_t per_day = framesPerDay(stream.rate, stream.drop_frame);
+                    int hour, min, sec, frame;
+                    fromFrameCount(stream.next % per_day, stream.rate, stream.drop_frame, hour, min, sec, frame);
+                    time.hours = hour;
+                    time.mins = min;
+                    time.secs = sec;
+                    time.frame = frame;
+                    if(stream.settings.flags & LTC_USE_DATE) {
+                        int year, month, day;
+                        civilFromDays(date + stream.next / per_day, year, month, day);
+                        time.years = year % 100;
+                        time.months = month;
+                        time.days = day;
+                        std::memcpy(time.timezone, timezone, sizeof(time.timezone));
+                    }
+                    stream.encoder.show(time, stream.drop_frame);
+                    ++stream.next;
+                    if(frame_callback) frame_callback(index, from + j, stream.encoder.getFrame());
+                });
+                return true;
+            }
+            
+            // days since 1970-01-01 in the proleptic Gregorian calendar, and back
+            static std::int64_t daysFromCivil(int year, int month, int day) {
+                const std::int64_t y = year - (month <= 2 ? 1 : 0);
+                const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+                const std::int64_t yoe = y - era * 400;
+                const std::int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+                const std::int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+                return era * 146097 + doe - 719468;
+            }
+            
+            static void civilFromDays(std::int64_t days, int &year, int &month, int &day) {
+                days += 719468;
+                const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+                const std::int64_t doe = days - era * 146097;
+                const std::int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+                const std::int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+                const std::int64_t mp = (5 * doy + 2) / 153;
+                day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+                month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+                year = static_cast<int>(yoe + era * 400 + (month <= 2 ? 1 : 0));
+            }
+            
+            double sample_rate{48000.0};
+            std::int64_t date{0}; // days since 1970-01-01 at timeline 0
+            char timezone[6]{'+', '0', '0', '0', '0', '\0'};
+            std::vector<std::unique_ptr<Stream>> streams;
+            std::vector<float> scratch; // one stream's samples of the callback
+            std::function<void(std::size_t, std::int64_t, const LTCFrame &)> frame_callback;
+            
+            // audio thread
+            std::int64_t timeline{0}; // samples since midnight
+            std::int64_t position{0};
+            std::uint32_t applied_locate{0};
+            bool was_playing{false};
+            
+            std::atomic<double> locate_time{0.0};
+            std::atomic<std::uint32_t> locate_request{0};
+            std::atomic<bool> playing{false};
+        };
+    };
+};
+
+#endif /* ofxLTC_Generator_h */
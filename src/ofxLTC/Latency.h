@@ -0,0 +1,49 @@
+//
+//  Latency.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_Latency_h
+#define ofxLTC_Latency_h
+
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace ofx {
+    namespace LTC {
+        // buffering latency of a sound device in seconds
+        struct DeviceLatency {
+            double input{0.0};  // signal at the jack -> sample handed to audioIn
+            double output{0.0}; // sample produced by audioOut -> signal at the jack
+        };
+        
+        namespace detail {
+            inline std::map<std::string, DeviceLatency> &latencyTable() {
+                static std::map<std::string, DeviceLatency> table;
+                return table;
+            }
+            inline std::mutex &latencyMutex() {
+                static std::mutex mutex;
+                return mutex;
+            }
+        };
+        
+        // per-device offsets picked up by Receiver::setup / Sender::setup
+        // for the device named in the stream settings.
+        inline void setDeviceLatency(const std::string &device_name,
+                                     const DeviceLatency &latency)
+        {
+            std::lock_guard<std::mutex> lock(detail::latencyMutex());
+            detail::latencyTable()[device_name] = latency;
+        }
+        
+        inline DeviceLatency getDeviceLatency(const std::string &device_name) {
+            std::lock_guard<std::mutex> lock(detail::latencyMutex());
+            auto it = detail::latencyTable().find(device_name);
+            return it == detail::latencyTable().end() ? DeviceLatency{} : it->second;
+        }
+    };
+};
+
+#endif /* ofxLTC_Latency_h */
@@ -0,0 +1,211 @@
+//
+//  Loopback.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_Loopback_h
+#define ofxLTC_Loopback_h
+
+#include "../ofxLTC.h"
+#include "SeqLock.h"
+#include "SpscQueue.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ofx {
+    namespace LTC {
+        // connects a Sender's encoded samples straight to a Receiver in-process,
+        // without a sound device, to measure the delay added by the codec itself.
+        // both must be set up with setupEncoder / setupDecoder at the same sample rate.
+        // note: replaces the onSend / onReceive handlers and plays the sender while it runs.
+        class Loopback {
+        public:
+            Loopback(Sender &sender, Receiver &receiver)
+            : sender(sender)
+            , receiver(receiver) {};
+            
+            void run(std::size_t frames,
+                     std::size_t buffer_size = 64,
+                     std::size_t num_channels = 2)
+            {
+                const int fps = static_cast<int>(std::round(sender.getFps()));
+                std::map<std::int64_t, std::int64_t> sent; // frame count -> first sample
+                delay_sum = 0.0;
+                matched = 0;
+                
+                const std::function<void(Timecode)> on_send = sender.getOnSend();
+                const std::function<void(Timecode)> on_receive = receiver.getOnReceive();
+                sender.onSend([&](Timecode timecode) {
+                    sent[toFrameCount(timecode.raw_data.ltc, fps)] = timecode.samplePosition;
+                });
+                receiver.onReceive([&](Timecode timecode) {
+                    if(timecode.extrapolated) return;
+                    auto it = sent.find(toFrameCount(timecode.raw_data.ltc, fps));
+                    if(it == sent.end()) return;
+                    delay_sum += static_cast<double>(timecode.raw_data.off_start - it->second);
+                    ++matched;
+                });
+                
+                // the sender moves on a frame per frame it encodes. this runs far
+                // faster than real time, so it encodes in audioOut meanwhile.
+                const std::size_t render_ahead = sender.getRenderAhead();
+                if(render_ahead) sender.setRenderAhead(0);
+                const bool was_playing = sender.isPlaying();
+                sender.start();
+                
+                ofSoundBuffer buffer;
+                buffer.allocate(buffer_size, num_channels);
+                buffer.setSampleRate(sender.getSampleRate());
+                const double samples_per_frame = sender.getSampleRate() / sender.getFps();
+                // one extra frame, the decoder completes a frame on the following edge
+                const std::size_t total = static_cast<std::size_t>((frames + 1) * samples_per_frame);
+                for(std::size_t done = 0; done < total; done += buffer_size) {
+                    sender.audioOut(buffer);
+                    receiver.audioIn(buffer);
+                }
+                
+                if(!was_playing) sender.stop();
+                if(render_ahead) sender.setRenderAhead(render_ahead);
+                sender.onSend(on_send);
+                receiver.onReceive(on_receive);
+            }
+            
+            // where the receiver puts a frame's start relative to where the
+            // sender started it, in samples. positive means late.
+            double getCodecDelay() const
+            { return matched ? delay_sum / matched : 0.0; };
+            
+            double getCodecDelaySeconds() const
+            { return getCodecDelay() / receiver.getSampleRate(); };
+            
+            std::size_t getMatchedFrames() const
+            { return matched; };
+            
+        protected:
+            Sender &sender;
+            Receiver &receiver;
+            double delay_sum{0.0};
+            std::size_t matched{0ul};
+        };
+        
+        // measures the hardware round trip with a physical cable from the
+        // sender's output to the receiver's input. start the sender, call begin(),
+        // let it run for a few seconds, then end() and apply().
+        // device latencies are zeroed while measuring, end() puts them and the
+        // onSend / onReceive handlers back. the handlers it installs run on the
+        // audio threads and neither lock nor allocate.
+        class RoundTripCalibration {
+        public:
+            RoundTripCalibration(Sender &sender, Receiver &receiver)
+            : sender(sender)
+            , receiver(receiver)
+            , sent(new SeqLock<SentFrame>[history])
+            , measured(4096) {};
+            
+            // codec delay from Loopback, removed from the measurement
+            void setCodecDelay(double seconds)
+            { codec_delay = seconds; };
+            
+            // not while measuring
+            void begin() {
+                std::lock_guard<std::mutex> lock(mutex);
+                for(std::size_t i = 0; i < history; ++i) sent[i].store(SentFrame{-1, 0.0});
+                double delay;
+                while(measured.pop(delay)) {}
+                delays.clear();
+                delays.reserve(measured.capacity());
+                
+                on_send = sender.getOnSend();
+                on_receive = receiver.getOnReceive();
+                output_latency = sender.getOutputLatency();
+                input_latency = receiver.getInputLatency();
+                sender.setOutputLatency(0.0);
+                receiver.setInputLatency(0.0);
+                
+                const int fps = static_cast<int>(std::round(sender.getFps()));
+                sender.onSend([this, fps](Timecode timecode) {
+                    const std::int64_t count = toFrameCount(timecode.raw_data.ltc, fps);
+                    if(count < 0) return;
+                    sent[count % history].store(SentFrame{count, timecode.monotonicTime});
+                });
+                receiver.onReceive([this, fps](Timecode timecode) {
+                    if(timecode.extrapolated) return;
+                    const std::int64_t count = toFrameCount(timecode.raw_data.ltc, fps);
+                    if(count < 0) return;
+                    const SentFrame frame = sent[count % history].load();
+                    if(frame.count != count) return;
+                    const double start = timecode.monotonicTime
+                                       - (timecode.samplePosition - timecode.raw_data.off_start) / receiver.getSampleRate();
+                    measured.push(start - frame.time - codec_delay);
+                });
+            }
+            
+            void end() {
+                sender.onSend(on_send);
+                receiver.onReceive(on_receive);
+                sender.setOutputLatency(output_latency);
+                receiver.setInputLatency(input_latency);
+            }
+            
+            // median round trip in seconds
+            double getRoundTrip() const {
+                std::lock_guard<std::mutex> lock(mutex);
+                collect();
+                if(delays.empty()) return 0.0;
+                std::vector<double> sorted = delays;
+                std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+                return sorted[sorted.size() / 2];
+            }
+            
+            std::size_t getMatchedFrames() const {
+                std::lock_guard<std::mutex> lock(mutex);
+                collect();
+                return delays.size();
+            }
+            
+            // the round trip can't tell input from output, split it by input_share
+            void apply(double input_share = 0.5) {
+                const double round_trip = getRoundTrip();
+                receiver.setInputLatency(round_trip * input_share);
+                sender.setOutputLatency(round_trip * (1.0 - input_share));
+            }
+            
+        protected:
+            struct SentFrame {
+                std::int64_t count; // -1 for none
+                double time; // monotonic
+            };
+            
+            // a few seconds of frames at any rate
+            static constexpr std::size_t history = 256;
+            
+            // the delays measured so far, by the UI thread holding mutex
+            void collect() const {
+                double delay;
+                while(delays.size() < delays.capacity() && measured.pop(delay)) delays.push_back(delay);
+            }
+            
+            Sender &sender;
+            Receiver &receiver;
+            double codec_delay{0.0};
+            std::unique_ptr<SeqLock<SentFrame>[]> sent; // by frame count % history, sender's audio thread
+            mutable SpscQueue<double> measured; // receiver's audio thread -> collect()
+            mutable std::mutex mutex;
+            mutable std::vector<double> delays;
+            std::function<void(Timecode)> on_send;
+            std::function<void(Timecode)> on_receive;
+            double output_latency{0.0};
+            double input_latency{0.0};
+        };
+    };
+};
+
+using ofxLTCLoopback = ofx::LTC::Loopback;
+using ofxLTCRoundTripCalibration = ofx::LTC::RoundTripCalibration;
+
+#endif /* ofxLTC_Loopback_h */
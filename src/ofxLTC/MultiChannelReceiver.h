@@ -0,0 +1,88 @@
+//
+//  MultiChannelReceiver.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_MultiChannelReceiver_h
+#define ofxLTC_MultiChannelReceiver_h
+
+#include "../ofxLTC.h"
+#include "ParallelDecoder.h"
+
+#include <memory>
+
+namespace ofx {
+    namespace LTC {
+        // decodes every input channel of one device (e.g. 64 MADI channels)
+        // on a pool of worker threads, see ParallelDecoder.
+        // frames are delivered from the audio thread one buffer after they arrived.
+        class MultiChannelReceiver {
+        public:
+            ~MultiChannelReceiver() {
+                soundStream.close();
+            }
+            
+            // num_threads 0: one per hardware thread
+            void setup(const ofSoundStreamSettings &settings,
+                       std::size_t num_threads = 0ul)
+            {
+                ofSoundStreamSettings settings_ = settings;
+                settings_.setInListener(this);
+                setupDecoder(settings_.sampleRate, settings_.numInputChannels, num_threads, settings_.bufferSize);
+                if(settings_.getInDevice()) {
+                    sample_clock.latency = -getDeviceLatency(settings_.getInDevice()->name).input;
+                }
+                soundStream.setup(settings_);
+            }
+            
+            // buffers are decoded without allocating, ones over max_buffer_size frames in parts
+            void setupDecoder(double sample_rate, std::size_t num_channels,
+                              std::size_t num_threads = 0ul,
+                              std::size_t max_buffer_size = 4096ul)
+            {
+                if(num_threads == 0) {
+                    num_threads = std::max(1u, std::thread::hardware_concurrency());
+                }
+                sample_clock.reset(sample_rate);
+                position = 0;
+                decoder.reset(new ParallelDecoder(num_channels, num_threads, 1920, max_buffer_size));
+                decoder->onFrame([this](std::size_t channel, const LTCFrameExt &frame) {
+                    Timecode timecode = makeTimecode(frame);
+                    timecode.monotonicTime = sample_clock.timeOf(frame.off_end);
+                    timecode.receivedTime = ofGetElapsedTimef() - static_cast<float>(getMonotonicTime() - timecode.monotonicTime);
+                    callback(channel, timecode);
+                });
+            }
+            
+            // (channel, timecode)
+            void onReceive(const std::function<void(std::size_t, Timecode)> &callback)
+            { this->callback = callback; };
+            
+            void audioIn(ofSoundBuffer &buffer) {
+                if(!decoder) return;
+                const std::size_t frames = buffer.getNumFrames();
+                sample_clock.update(getMonotonicTime(), position + static_cast<std::int64_t>(frames));
+                decoder->process(buffer.getBuffer().data(), frames, buffer.getNumChannels(), position);
+                position += frames;
+            }
+            
+            // worker timing; last_batch / max_batch is the measured decode time per buffer
+            ParallelDecoder::Stats getStats() const
+            { return decoder ? decoder->getStats() : ParallelDecoder::Stats{}; };
+            
+            std::vector<ofSoundDevice> getDeivceList() const
+            { return soundStream.getDeviceList(); };
+            
+        protected:
+            ofSoundStream soundStream;
+            std::unique_ptr<ParallelDecoder> decoder;
+            SampleClock sample_clock;
+            std::int64_t position{0};
+            std::function<void(std::size_t, Timecode)> callback{[](std::size_t, Timecode) {}};
+        };
+    };
+};
+
+using ofxLTCMultiChannelReceiver = ofx::LTC::MultiChannelReceiver;
+
+#endif /* ofxLTC_MultiChannelReceiver_h */
@@ -0,0 +1,304 @@
+//
+//  OfflineDecoder.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_OfflineDecoder_h
+#define ofxLTC_OfflineDecoder_h
+
+#include "ltc.h"
+#include "AudioFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace ofx {
+    namespace LTC {
+        // true if both frames carry the same word, offsets, timing and level
+        inline bool sameFrame(const LTCFrameExt &a, const LTCFrameExt &b) {
+            return !std::memcmp(&a.ltc, &b.ltc, LTC_FRAME_BIT_COUNT / 8)
+                && a.off_start == b.off_start
+                && a.off_end == b.off_end
+                && a.reverse == b.reverse
+                && !std::memcmp(a.biphase_tics, b.biphase_tics, sizeof(a.biphase_tics))
+                && a.sample_min == b.sample_min
+                && a.sample_max == b.sample_max
+                && a.volume == b.volume;
+        }
+        
+        // decodes the LTC on one channel of an AudioFile as fast as the CPU allows.
+        // off_start / off_end of the frames are sample frames from the start of the file.
+        //
+        // with threads > 1 the range is split into chunks that are decoded
+        // concurrently. each chunk starts `warmup` samples early so the envelope
+        // and period trackers settle, keeps the frames starting inside it and
+        // decodes the same distance past its end. the frames both neighbours
+        // decoded there have to match, otherwise the later chunk is decoded
+        // again continuing a copy of the earlier one's decoder. those are
+        // decoded concurrently as well, in rounds when several seams in a row
+        // differ. the result is the sequential decode.
+        // does not depend on openFrameworks.
+        class OfflineDecoder {
+        public:
+            struct Settings {
+                std::size_t channel{0};
+                double fps{25.0}; // only the decoder's first guess of the bit period
+                std::size_t block_size{8192}; // samples converted and decoded at a time
+                std::size_t threads{1};
+                std::int64_t chunk_size{0}; // samples per chunk, 0: 4 chunks per thread, at least 64 frames
+                std::int64_t warmup{0}; // samples, 0: 4 frames, at least 2 frames
+            };
+            
+            struct Stats {
+                std::size_t chunks{0};
+                std::size_t redecoded{0}; // chunks whose seam didn't match
+                std::int64_t redecoded_samples{0}; // decoded a second time
+            };
+            
+            OfflineDecoder(const AudioFile &file, const Settings &settings)
+            : file(file)
+            , settings(settings)
+            {};
+            
+            OfflineDecoder(const AudioFile &file)
+            : OfflineDecoder(file, Settings()) {};
+            
+            void onFrame(const std::function<void(const LTCFrameExt &)> &callback)
+            { this->callback = callback; };
+            
+            // decodes sample frames [begin, end), end < 0 means the end of the file.
+            // frames are delivered in order on the calling thread.
+            // returns the number of LTC frames found.
+            std::size_t decode(std::int64_t begin = 0, std::int64_t end = -1) {
+                const std::int64_t length = file.getNumFrames();
+                if(end < 0 || length < end) end = length;
+                stats = Stats();
+                if(end <= begin) return 0;
+                if(settings.threads <= 1) {
+                    stats.chunks = 1;
+                    return run(begin, end, callback);
+                }
+                return decodeChunks(begin, end);
+            }
+            
+            Stats getStats() const
+            { return stats; };
+            
+        protected:
+            typedef std::unique_ptr<LTCDecoder, int (*)(LTCDecoder *)> DecoderPtr;
+            
+            struct Chunk {
+                std::int64_t begin{0}, end{0}; // frames starting here belong to this chunk
+                std::int64_t origin{0}; // where its decoder started
+                std::int64_t stop{0}; // and stopped
+                // frames starting before begin and ending here or later were
+                // never finished by the previous chunk and belong to this one
+                std::int64_t handed_over{std::numeric_limits<std::int64_t>::max()};
+                std::vector<LTCFrameExt> frames; // all frames decoded, in order
+                DecoderPtr state{nullptr, ltc_decoder_free}; // the decoder at end
+            };
+            
+            int samplesPerFrame() const
+            { return std::max(1, static_cast<int>(file.getSampleRate() / settings.fps)); };
+            
+            DecoderPtr createDecoder() const {
+                const int apv = samplesPerFrame();
+                // the queue must hold every frame of a block, even at twice the speed
+                const int queue = static_cast<int>(2 * settings.block_size / apv) + 8;
+                return DecoderPtr(ltc_decoder_create(apv, queue), ltc_decoder_free);
+            }
+            
+            // feeds [begin, end) to the decoder, returns the number of frames
+            std::size_t feed(LTCDecoder *decoder, std::int64_t begin, std::int64_t end,
+                             const std::function<void(const LTCFrameExt &)> &emit) const
+            {
+                std::vector<ltcsnd_sample_t> block(settings.block_size);
+                std::size_t found = 0;
+                LTCFrameExt frame;
+                for(std::int64_t pos = begin; pos < end; pos += settings.block_size) {
+                    const std::size_t count = static_cast<std::size_t>(std::min<std::int64_t>(settings.block_size, end - pos));
+                    const std::size_t got = file.read(pos, count, settings.channel, block.data());
+                    if(got == 0) break;
+                    ltc_decoder_write(decoder, block.data(), got, pos);
+                    while(ltc_decoder_read(decoder, &frame)) {
+                        ++found;
+                        emit(frame);
+                    }
+                }
+                return found;
+            }
+            
+            std::size_t run(std::int64_t begin, std::int64_t end,
+                            const std::function<void(const LTCFrameExt &)> &emit) const
+            { return feed(createDecoder().get(), begin, end, emit); };
+            
+            // decodes [origin, stop) with a fresh decoder or continuing `from`,
+            // keeping a copy of the decoder at chunk.end for the next chunk
+            void runChunk(Chunk &chunk, std::int64_t origin, std::int64_t stop, const LTCDecoder *from = nullptr) const {
+                chunk.origin = origin;
+                chunk.stop = stop;
+                chunk.frames.clear();
+                DecoderPtr decoder = from ? DecoderPtr(ltc_decoder_copy(from), ltc_decoder_free) : createDecoder();
+                auto keep = [&chunk](const LTCFrameExt &f) { chunk.frames.push_back(f); };
+                feed(decoder.get(), origin, chunk.end, keep);
+                chunk.state.reset(ltc_decoder_copy(decoder.get()));
+                feed(decoder.get(), chunk.end, stop, keep);
+            }
+            
+            // does `next` have exactly the frames `prev` found past its end,
+            // and did `prev` finish every frame it owns?
+            static bool seamMatches(const Chunk &prev, const Chunk &next) {
+                std::vector<const LTCFrameExt *> a, b;
+                for(const LTCFrameExt &f : prev.frames) {
+                    if(prev.end <= f.off_start) a.push_back(&f);
+                }
+                for(const LTCFrameExt &f : next.frames) {
+                    if(f.off_start < next.begin && prev.stop <= f.off_end) return false;
+                    if(next.begin <= f.off_start && f.off_end < prev.stop) b.push_back(&f);
+                }
+                if(a.size() != b.size()) return false;
+                for(std::size_t i = 0; i < a.size(); ++i) {
+                    if(!sameFrame(*a[i], *b[i])) return false;
+                }
+                return true;
+            }
+            
+            // fn(0) .. fn(count - 1) on up to settings.threads threads
+            template<typename Function>
+            void forEach(std::size_t count, Function fn) const {
+                std::atomic<std::size_t> next{0};
+                auto work = [&] {
+                    for(std::size_t k; (k = next.fetch_add(1)) < count;) fn(k);
+                };
+                std::vector<std::thread> pool;
+                for(std::size_t t = 1; t < std::min(settings.threads, count); ++t) pool.emplace_back(work);
+                work();
+                for(std::thread &thread : pool) thread.join();
+            }
+            
+            std::size_t decodeChunks(std::int64_t begin, std::int64_t end) {
+                const std::int64_t apv = samplesPerFrame();
+                // a frame is only lost at a seam if it is longer than both overlaps,
+                // i.e. slower than 1/8 speed with the default.
+                const std::int64_t warmup = std::max(2 * apv, 0 < settings.warmup ? settings.warmup : 4 * apv);
+                std::int64_t chunk_size = settings.chunk_size;
+                if(chunk_size <= 0) {
+                    chunk_size = std::max<std::int64_t>(64 * apv, (end - begin) / static_cast<std::int64_t>(4 * settings.threads) + 1);
+                }
+                chunk_size = std::max(chunk_size, warmup);
+                
+                std::vector<Chunk> chunks;
+                for(std::int64_t b = begin; b < end; b += chunk_size) {
+                    Chunk chunk;
+                    chunk.begin = b;
+                    chunk.end = std::min(end, b + chunk_size);
+                    chunks.push_back(std::move(chunk));
+                }
+                stats.chunks = chunks.size();
+                // the decoder can date the very first frame before `begin`
+                chunks.front().handed_over = std::numeric_limits<std::int64_t>::min();
+                
+                forEach(chunks.size(), [&](std::size_t k) {
+                    Chunk &chunk = chunks[k];
+                    const std::int64_t origin = k == 0 ? begin : std::max(begin, chunk.begin - warmup);
+                    runChunk(chunk, origin, std::min(end, chunk.end + warmup));
+                });
+                
+                // a chunk is settled when it follows a settled one and their seam
+                // matches, or once it was decoded again continuing that one. the
+                // differing seams behind settled chunks are decoded again together.
+                std::vector<char> settled(chunks.size(), 0);
+                settled[0] = 1;
+                for(;;) {
+                    std::vector<std::size_t> again;
+                    for(std::size_t k = 1; k < chunks.size(); ++k) {
+                        if(settled[k] || !settled[k - 1]) continue;
+                        if(seamMatches(chunks[k - 1], chunks[k])) settled[k] = 1;
+                        else again.push_back(k);
+                    }
+                    if(again.empty()) break;
+                    forEach(again.size(), [&](std::size_t i) {
+                        Chunk &prev = chunks[again[i] - 1];
+                        Chunk &chunk = chunks[again[i]];
+                        runChunk(chunk, chunk.begin, std::min(end, chunk.end + warmup), prev.state.get());
+                        // frames prev didn't finish are this chunk's now
+                        chunk.handed_over = prev.stop;
+                    });
+                    for(std::size_t k : again) {
+                        settled[k] = 1;
+                        ++stats.redecoded;
+                        stats.redecoded_samples += chunks[k].stop - chunks[k].begin;
+                    }
+                }
+                
+                std::size_t found = 0;
+                for(Chunk &chunk : chunks) {
+                    for(const LTCFrameExt &f : chunk.frames) {
+                        if(chunk.end <= f.off_start) continue;
+                        if(f.off_start < chunk.begin && f.off_end < chunk.handed_over) continue;
+                        ++found;
+                        callback(f);
+                    }
+                    std::vector<LTCFrameExt>().swap(chunk.frames);
+                }
+                return found;
+            }
+            
+            const AudioFile &file;
+            Settings settings;
+            Stats stats;
+            std::function<void(const LTCFrameExt &)> callback{[](const LTCFrameExt &) {}};
+        };
+        
+        // fixed size little endian record of the binary frame list ltc_decode writes
+        // after a FrameRecord::Header. the LTC frame is the raw 80 bit SMPTE word.
+        struct FrameRecord {
+            struct Header {
+                char magic[4]; // "LTCF"
+                std::uint32_t version;
+                double sample_rate;
+                std::uint32_t channel;
+                std::uint32_t record_size;
+            };
+            
+            std::int64_t off_start;
+            std::int64_t off_end;
+            unsigned char frame[LTC_FRAME_BIT_COUNT / 8]; // the first 10 bytes of LTCFrame
+            std::uint8_t reverse;
+            std::uint8_t reserved;
+            float volume; // dBFS
+            
+            static Header header(double sample_rate, std::size_t channel) {
+                Header h;
+                std::memcpy(h.magic, "LTCF", 4);
+                h.version = 1;
+                h.sample_rate = sample_rate;
+                h.channel = static_cast<std::uint32_t>(channel);
+                h.record_size = sizeof(FrameRecord);
+                return h;
+            }
+            
+            static FrameRecord from(const LTCFrameExt &f) {
+                FrameRecord r;
+                r.off_start = f.off_start;
+                r.off_end = f.off_end;
+                std::memcpy(r.frame, &f.ltc, sizeof(r.frame));
+                r.reverse = static_cast<std::uint8_t>(f.reverse);
+                r.reserved = 0;
+                r.volume = static_cast<float>(f.volume);
+                return r;
+            }
+        };
+        static_assert(sizeof(FrameRecord) == 32, "FrameRecord is written as is");
+        static_assert(sizeof(FrameRecord::Header) == 24, "FrameRecord::Header is written as is");
+    };
+};
+
+#endif /* ofxLTC_OfflineDecoder_h */
@@ -0,0 +1,269 @@
+//
+//  ParallelDecoder.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_ParallelDecoder_h
+#define ofxLTC_ParallelDecoder_h
+
+#include "ltc.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace ofx {
+    namespace LTC {
+        // decodes many LTC channels of one interleaved stream on a fixed pool of
+        // worker threads. process() copies buffer k into a queue of queue_depth
+        // preallocated slots and returns; the workers decode the queued buffers
+        // in order and the frames of the buffers they finished are delivered at
+        // the start of the next process(), so the added latency is one buffer
+        // while the workers keep up. channels are split into a contiguous range
+        // per worker, idle workers steal from the other ranges.
+        // process() never blocks, locks or allocates: the workers poll for
+        // buffers. an overrun only delays the frames, a buffer is dropped (and
+        // counted) when queue_depth buffers are already waiting.
+        // does not depend on openFrameworks.
+        class ParallelDecoder {
+        public:
+            struct Stats {
+                double last_batch{0.0}; // seconds the workers took for the last buffer
+                double max_batch{0.0};
+                std::size_t overruns{0ul}; // buffers that came while the workers were still on an earlier one
+                std::size_t dropped{0ul}; // buffers not decoded, the queue was full
+                std::size_t batches{0ul};
+            };
+            
+            ParallelDecoder(std::size_t num_channels, std::size_t num_threads,
+                            int samples_per_frame = 1920,
+                            std::size_t max_buffer_size = 4096ul,
+                            std::size_t queue_depth = 4ul)
+            : channels(num_channels)
+            , num_workers(std::max<std::size_t>(1, num_threads))
+            , max_buffer_size(max_buffer_size)
+            // a buffer at up to 4x speed, at most what the decoder queue holds
+            , frames_per_slot(std::min<std::size_t>(32, max_buffer_size * 4 / std::max(1, samples_per_frame) + 2))
+            , slots(std::max<std::size_t>(2, queue_depth))
+            {
+                for(auto &channel : channels) {
+                    channel.decoder = ltc_decoder_create(samples_per_frame, 32);
+                }
+                for(auto &slot : slots) {
+                    slot.input.resize(max_buffer_size * channels.size());
+                    slot.frames.resize(frames_per_slot * channels.size());
+                    slot.num_frames.resize(channels.size());
+                    slot.ranges.reset(new Range[num_workers]);
+                }
+                for(std::size_t i = 0; i < num_workers; ++i) {
+                    workers.emplace_back([this, i] { work(i); });
+                }
+            }
+            
+            ~ParallelDecoder() {
+                quit = true;
+                for(auto &worker : workers) worker.join();
+                for(auto &channel : channels) ltc_decoder_free(channel.decoder);
+            }
+            
+            // (channel, frame), called from the thread calling process()
+            void onFrame(const std::function<void(std::size_t, const LTCFrameExt &)> &callback)
+            { this->callback = callback; };
+            
+            // interleaved float samples, `stride` values per sample frame, channel c at offset c.
+            // position is the stream sample of the first frame in the buffer.
+            // buffers over max_buffer_size frames take several slots.
+            void process(const float *interleaved, std::size_t frames,
+                         std::size_t stride, std::int64_t position)
+            {
+                deliver();
+                for(std::size_t done = 0; done < frames;) {
+                    const std::size_t count = std::min(frames - done, max_buffer_size);
+                    submit(interleaved + done * stride, count, stride, position + static_cast<std::int64_t>(done));
+                    done += count;
+                }
+            }
+            
+            // wait for the buffers in flight and deliver their frames
+            void flush() {
+                while(completed.load(std::memory_order_acquire) != submitted.load(std::memory_order_relaxed)) {
+                    std::this_thread::yield();
+                }
+                deliver();
+            }
+            
+            std::size_t getNumChannels() const
+            { return channels.size(); };
+            
+            std::size_t getNumThreads() const
+            { return num_workers; };
+            
+            // from any thread
+            Stats getStats() const {
+                Stats stats;
+                stats.last_batch = last_batch.load(std::memory_order_relaxed);
+                stats.max_batch = max_batch.load(std::memory_order_relaxed);
+                stats.overruns = overruns.load(std::memory_order_relaxed);
+                stats.dropped = dropped.load(std::memory_order_relaxed);
+                stats.batches = batches.load(std::memory_order_relaxed);
+                return stats;
+            }
+            
+        protected:
+            typedef std::chrono::steady_clock clock_type;
+            
+            struct Channel {
+                LTCDecoder *decoder{nullptr};
+            };
+            
+            // one per worker, padded to a cache line so stealing doesn't thrash
+            struct Range {
+                std::atomic<std::size_t> next{0};
+                std::size_t end{0};
+                char padding[64 - sizeof(std::atomic<std::size_t>) - sizeof(std::size_t)];
+            };
+            
+            // a queued buffer and, once decoded, its frames
+            struct Slot {
+                std::vector<float> input; // the decoded channels, interleaved
+                std::size_t num_samples{0ul};
+                std::int64_t position{0};
+                clock_type::time_point submit_time;
+                std::unique_ptr<Range[]> ranges;
+                std::atomic<std::size_t> busy_workers{0ul};
+                std::vector<LTCFrameExt> frames; // frames_per_slot per channel
+                std::vector<std::size_t> num_frames; // per channel
+            };
+            
+            // process() thread: queue one buffer of at most max_buffer_size frames
+            void submit(const float *interleaved, std::size_t frames, std::size_t stride, std::int64_t position) {
+                const std::uint64_t n = submitted.load(std::memory_order_relaxed);
+                if(n - delivered == slots.size()) deliver();
+                if(n - delivered == slots.size()) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                if(completed.load(std::memory_order_acquire) != n) overruns.fetch_add(1, std::memory_order_relaxed);
+                
+                Slot &slot = slots[n % slots.size()];
+                const std::size_t num_channels = channels.size();
+                for(std::size_t i = 0; i < frames; ++i) {
+                    std::copy(interleaved + i * stride, interleaved + i * stride + num_channels, slot.input.data() + i * num_channels);
+                }
+                slot.num_samples = frames;
+                slot.position = position;
+                slot.submit_time = clock_type::now();
+                const std::size_t per_worker = (num_channels + num_workers - 1) / num_workers;
+                for(std::size_t i = 0; i < num_workers; ++i) {
+                    slot.ranges[i].next.store(std::min(i * per_worker, num_channels), std::memory_order_relaxed);
+                    slot.ranges[i].end = std::min((i + 1) * per_worker, num_channels);
+                }
+                slot.busy_workers.store(num_workers, std::memory_order_relaxed);
+                submitted.store(n + 1, std::memory_order_release);
+            }
+            
+            // process() thread: the frames of every buffer the workers finished
+            void deliver() {
+                const std::uint64_t done = completed.load(std::memory_order_acquire);
+                for(; delivered < done; ++delivered) {
+                    const Slot &slot = slots[delivered % slots.size()];
+                    for(std::size_t c = 0; c < channels.size(); ++c) {
+                        for(std::size_t k = 0; k < slot.num_frames[c]; ++k) {
+                            callback(c, slot.frames[c * frames_per_slot + k]);
+                        }
+                    }
+                    batches.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            
+            // take the next channel from our own range, then steal from the others
+            bool take(Slot &slot, std::size_t worker, std::size_t &channel) {
+                for(std::size_t k = 0; k < num_workers; ++k) {
+                    Range &range = slot.ranges[(worker + k) % num_workers];
+                    if(range.end <= range.next.load(std::memory_order_relaxed)) continue;
+                    channel = range.next.fetch_add(1, std::memory_order_relaxed);
+                    if(channel < range.end) return true;
+                }
+                return false;
+            }
+            
+            void decode(Slot &slot, std::size_t c, std::vector<ltcsnd_sample_t> &scratch) {
+                const float *src = slot.input.data() + c;
+                const std::size_t stride = channels.size();
+                for(std::size_t i = 0; i < slot.num_samples; ++i) {
+                    scratch[i] = static_cast<ltcsnd_sample_t>((src[i * stride] + 1.0f) * 127.5f);
+                }
+                LTCDecoder *decoder = channels[c].decoder;
+                ltc_decoder_write(decoder, scratch.data(), slot.num_samples, slot.position);
+                // out of the decoder now, the next buffer may be decoded before this one is delivered
+                std::size_t k = 0;
+                while(k < frames_per_slot && ltc_decoder_read(decoder, &slot.frames[c * frames_per_slot + k])) ++k;
+                slot.num_frames[c] = k;
+            }
+            
+            void work(std::size_t worker) {
+                std::vector<ltcsnd_sample_t> scratch(max_buffer_size);
+                std::uint64_t batch = 0;
+                clock_type::time_point idle_since = clock_type::now();
+                while(!quit) {
+                    // the next buffer, once every worker is done with the one before.
+                    // spin a little after a buffer, back-to-back ones are common
+                    if(submitted.load(std::memory_order_acquire) <= batch) {
+                        if(clock_type::now() - idle_since < std::chrono::microseconds(50)) std::this_thread::yield();
+                        else std::this_thread::sleep_for(std::chrono::microseconds(100));
+                        continue;
+                    }
+                    if(completed.load(std::memory_order_acquire) < batch) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    Slot &slot = slots[batch % slots.size()];
+                    std::size_t c;
+                    while(take(slot, worker, c)) {
+                        decode(slot, c, scratch);
+                    }
+                    if(slot.busy_workers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        // from when the workers could start on it
+                        const clock_type::time_point now = clock_type::now();
+                        const clock_type::time_point previous(clock_type::duration(last_completion.load(std::memory_order_relaxed)));
+                        const double seconds = std::chrono::duration<double>(now - std::max(slot.submit_time, previous)).count();
+                        last_batch.store(seconds, std::memory_order_relaxed);
+                        if(max_batch.load(std::memory_order_relaxed) < seconds) max_batch.store(seconds, std::memory_order_relaxed);
+                        last_completion.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+                        completed.store(batch + 1, std::memory_order_release);
+                    }
+                    ++batch;
+                    idle_since = clock_type::now();
+                }
+            }
+            
+            std::vector<Channel> channels;
+            std::size_t num_workers;
+            std::size_t max_buffer_size;
+            std::size_t frames_per_slot;
+            std::vector<Slot> slots; // buffer k in slots[k % size]
+            std::vector<std::thread> workers;
+            
+            std::atomic<bool> quit{false};
+            std::atomic<std::uint64_t> submitted{0}; // buffers queued by process()
+            std::atomic<std::uint64_t> completed{0}; // buffers decoded by the workers, in order
+            std::uint64_t delivered{0}; // buffers whose frames went out, process() thread only
+            std::atomic<clock_type::rep> last_completion{0};
+            
+            std::atomic<double> last_batch{0.0};
+            std::atomic<double> max_batch{0.0};
+            std::atomic<std::size_t> overruns{0ul};
+            std::atomic<std::size_t> dropped{0ul};
+            std::atomic<std::size_t> batches{0ul};
+            std::function<void(std::size_t, const LTCFrameExt &)> callback{[](std::size_t, const LTCFrameExt &) {}};
+        };
+    };
+};
+
+#endif /* ofxLTC_ParallelDecoder_h */
@@ -0,0 +1,293 @@
+//
+//  RedundantReceiver.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_RedundantReceiver_h
+#define ofxLTC_RedundantReceiver_h
+
+#include "../ofxLTC.h"
+#include "SpscQueue.h"
+#include "StreamHub.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ofx {
+    namespace LTC {
+        // decodes the same LTC from two or more inputs and delivers one merged stream.
+        // each input is scored by signal level, parity and continuity. the merged
+        // stream follows the best input and fails over as soon as the active one
+        // misses a frame the others delivered, without repeating or skipping frames.
+        // each input's audio thread only queues its frames; one merge thread
+        // decides and runs the callbacks, in order and without holding a lock.
+        class RedundantReceiver {
+        public:
+            struct InputStatus {
+                double volume{-INFINITY}; // dBFS of the last frame
+                int sample_min{128};
+                int sample_max{128};
+                bool parity_valid{false};
+                bool continuous{false};
+                double score{0.0}; // 0..1, smoothed
+                double last_time{0.0}; // monotonic time of the last frame
+                std::size_t frames{0ul};
+                std::size_t dropped{0ul}; // frames lost to a full queue
+            };
+            
+            RedundantReceiver() = default;
+            RedundantReceiver(const RedundantReceiver &) = delete;
+            RedundantReceiver &operator=(const RedundantReceiver &) = delete;
+            
+            ~RedundantReceiver() {
+                running = false;
+                if(merge_thread.joinable()) merge_thread.join();
+            }
+            
+            // input on its own sound device / channel
+            std::size_t addInput(const ofSoundStreamSettings &settings,
+                                 std::size_t channel_offset = 0ul)
+            {
+                const std::size_t index = createInput();
+                inputs[index]->setup(settings, channel_offset);
+                return index;
+            }
+            
+            // input on one channel of a shared stream
+            std::size_t addInput(StreamHub &hub, std::size_t channel)
+            {
+                const std::size_t index = createInput();
+                hub.attach(*inputs[index], channel);
+                return index;
+            }
+            
+            // input fed by calling getInput(index).audioIn yourself
+            std::size_t addInput(double sample_rate,
+                                 std::size_t channel_offset = 0ul)
+            {
+                const std::size_t index = createInput();
+                inputs[index]->setupDecoder(sample_rate, channel_offset);
+                return index;
+            }
+            
+            Receiver &getInput(std::size_t index)
+            { return *inputs[index]; };
+            
+            std::size_t getNumInputs() const
+            { return inputs.size(); };
+            
+            void onReceive(const std::function<void(Timecode)> &callback)
+            { this->callback = callback; };
+            
+            // (previous input, new input)
+            void onSwitch(const std::function<void(std::size_t, std::size_t)> &callback)
+            { this->switch_callback = callback; };
+            
+            std::size_t getActiveInput() const
+            { return active.load(); };
+            
+            InputStatus getStatus(std::size_t index) const {
+                std::lock_guard<std::mutex> lock(mutex);
+                InputStatus input = status[index];
+                input.dropped = queues[index]->dropped.load(std::memory_order_relaxed);
+                return input;
+            }
+            
+            // how much better another input has to score to take over
+            void setHysteresis(double hysteresis)
+            { this->hysteresis = hysteresis; };
+            
+        protected:
+            // a frame on its way from an input's audio thread to the merge thread
+            struct Received {
+                TimecodeSnapshot timecode;
+                int fps; // the input's estimate when it decoded the frame
+            };
+            
+            // a decision of the merge thread, run after it lets go of the lock
+            struct Delivery {
+                bool is_switch;
+                std::size_t from, to; // of a switch
+                Timecode timecode; // of a frame
+            };
+            
+            struct InputQueue {
+                SpscQueue<Received> frames{64};
+                std::atomic<std::size_t> dropped{0ul};
+                Received head; // popped, waiting for its turn, merge thread only
+                bool has_head{false};
+            };
+            
+            std::size_t createInput() {
+                std::lock_guard<std::mutex> lock(mutex);
+                const std::size_t index = inputs.size();
+                queues.emplace_back(new InputQueue);
+                inputs.emplace_back(new Receiver);
+                status.emplace_back();
+                last_counts.push_back(-1);
+                InputQueue *queue = queues[index].get();
+                Receiver *input = inputs[index].get();
+                // the input's audio thread: no lock, no allocation
+                input->onReceive([queue, input](Timecode timecode) {
+                    // each input's own flywheel would only hide a failing path
+                    if(timecode.extrapolated) return;
+                    if(!queue->frames.push(Received{makeSnapshot(timecode), input->getFps()})) {
+                        queue->dropped.fetch_add(1, std::memory_order_relaxed);
+                    }
+                });
+                if(!merge_thread.joinable()) {
+                    running = true;
+                    merge_thread = std::thread([this] { merge(); });
+                }
+                return index;
+            }
+            
+            // takes the frames of all inputs in the order they arrived at their
+            // inputs, decides under the lock and delivers outside of it
+            void merge() {
+                std::vector<Delivery> decided;
+                while(running) {
+                    decided.clear();
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        for(;;) {
+                            std::size_t next = queues.size();
+                            for(std::size_t i = 0; i < queues.size(); ++i) {
+                                InputQueue &queue = *queues[i];
+                                if(!queue.has_head) queue.has_head = queue.frames.pop(queue.head);
+                                if(queue.has_head && (next == queues.size()
+                                                      || queue.head.timecode.monotonicTime < queues[next]->head.timecode.monotonicTime)) {
+                                    next = i;
+                                }
+                            }
+                            if(next == queues.size()) break;
+                            queues[next]->has_head = false;
+                            const Received &received = queues[next]->head;
+                            receive(next, makeTimecode(received.timecode), received.fps, decided);
+                        }
+                    }
+                    for(const Delivery &delivery : decided) {
+                        if(delivery.is_switch) switch_callback(delivery.from, delivery.to);
+                        else callback(delivery.timecode);
+                    }
+                    if(decided.empty()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+            
+            static bool isParityValid(const LTCFrame &frame, int fps) {
+                LTCFrame copy = frame;
+                const auto standard = (fps == 25) ? LTC_TV_625_50 : LTC_TV_525_60;
+                ltc_frame_set_parity(&copy, standard);
+                return (standard == LTC_TV_625_50)
+                     ? copy.binary_group_flag_bit2 == frame.binary_group_flag_bit2
+                     : copy.biphase_mark_phase_correction == frame.biphase_mark_phase_correction;
+            }
+            
+            bool isStale(const InputStatus &input, double now, double frame_duration) const
+            { return input.frames == 0 || frame_duration * 1.25 < now - input.last_time; };
+            
+            // one frame of input `index`, by the merge thread holding mutex
+            void receive(std::size_t index, const Timecode &timecode, int fps, std::vector<Delivery> &deliveries) {
+                if(fps <= 0) return;
+                
+                const std::int64_t count = toFrameCount(timecode.raw_data.ltc, fps);
+                const std::int64_t per_day = framesPerDay(fps, timecode.raw_data.ltc.dfbit != 0);
+                const int direction = timecode.reverse ? -1 : 1;
+                const double frame_duration = 1.0 / fps;
+                InputStatus &input = status[index];
+                const LTCFrameExt &raw = timecode.raw_data;
+                input.volume = raw.volume;
+                input.sample_min = raw.sample_min;
+                input.sample_max = raw.sample_max;
+                input.parity_valid = isParityValid(raw.ltc, fps);
+                input.continuous = (last_counts[index] >= 0)
+                                && wrapped(count - last_counts[index], per_day) == direction;
+                last_counts[index] = count;
+                
+                const bool clipped = raw.sample_min <= 1 || 254 <= raw.sample_max;
+                const double level = std::min(1.0, std::max(0.0, (raw.volume + 42.0) / 36.0));
+                const double instant = level
+                                     * (input.parity_valid ? 1.0 : 0.5)
+                                     * (input.continuous ? 1.0 : 0.5)
+                                     * (clipped ? 0.8 : 1.0);
+                input.score = input.frames ? input.score + (instant - input.score) * 0.3 : instant;
+                input.last_time = timecode.monotonicTime;
+                ++input.frames;
+                
+                std::size_t current = active.load();
+                if(current != index) {
+                    if(status.size() <= current
+                       || isStale(status[current], timecode.monotonicTime, frame_duration)
+                       || status[current].score + hysteresis < input.score)
+                    {
+                        if(current < inputs.size()) deliveries.push_back(Delivery{true, current, index, Timecode()});
+                        active.store(index);
+                        current = index;
+                    } else if(has_emitted && wrapped(count - last_emitted, per_day) == direction) {
+                        // the active input may still be about to deliver this frame.
+                        // keep it in case that input turns out to be gone.
+                        pending = timecode;
+                        pending_input = index;
+                        pending_count = count;
+                        has_pending = true;
+                    }
+                }
+                
+                if(current == index && has_pending && pending_input == index) {
+                    if(wrapped(pending_count - last_emitted, per_day) == direction) {
+                        deliveries.push_back(Delivery{false, 0ul, 0ul, pending});
+                        last_emitted = pending_count;
+                    }
+                    has_pending = false;
+                }
+                
+                if(current == index) {
+                    // drop what another input already delivered
+                    const std::int64_t step = wrapped(count - last_emitted, per_day);
+                    if(!has_emitted || direction * step > 0 || 4 < std::abs(step)) {
+                        deliveries.push_back(Delivery{false, 0ul, 0ul, timecode});
+                        last_emitted = count;
+                        has_emitted = true;
+                    }
+                }
+            }
+            
+            // frame difference folded into (-per_day / 2, per_day / 2]
+            static std::int64_t wrapped(std::int64_t diff, std::int64_t per_day) {
+                diff %= per_day;
+                if(per_day / 2 < diff) diff -= per_day;
+                if(diff <= -per_day / 2) diff += per_day;
+                return diff;
+            }
+            
+            // the state below is guarded by mutex, the audio threads never take it.
+            // the queues outlive the inputs that push into them.
+            std::vector<std::unique_ptr<InputQueue>> queues;
+            std::vector<std::unique_ptr<Receiver>> inputs;
+            std::vector<InputStatus> status;
+            std::vector<std::int64_t> last_counts;
+            mutable std::mutex mutex;
+            std::thread merge_thread;
+            std::atomic<bool> running{false};
+            std::atomic<std::size_t> active{static_cast<std::size_t>(-1)};
+            std::int64_t last_emitted{0};
+            bool has_emitted{false};
+            Timecode pending;
+            std::size_t pending_input{0ul};
+            std::int64_t pending_count{0};
+            bool has_pending{false};
+            double hysteresis{0.2};
+            std::function<void(Timecode)> callback{[](Timecode) {}};
+            std::function<void(std::size_t, std::size_t)> switch_callback{[](std::size_t, std::size_t) {}};
+        };
+    };
+};
+
+using ofxLTCRedundantReceiver = ofx::LTC::RedundantReceiver;
+
+#endif /* ofxLTC_RedundantReceiver_h */
@@ -0,0 +1,237 @@
+//
+//  RenderAhead.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_RenderAhead_h
+#define ofxLTC_RenderAhead_h
+
+#include "SpscQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace ofx {
+    namespace LTC {
+        // mono samples rendered ahead by a worker thread and played by the
+        // audio thread, in blocks of consecutive stream positions. filled and
+        // free blocks go back and forth through two SpscQueues, so neither
+        // side blocks, locks or allocates.
+        //
+        // requestRestart() invalidates everything rendered so far: at its next
+        // callback the audio thread picks the end of the frame playing at the
+        // end of that callback as the restart position, plays old blocks up to
+        // it and drops the rest. the worker is told the position and the last
+        // frame played before it, and renders the new generation from there.
+        // Info describes a frame starting in a block, handed to the audio thread
+        // when that sample is played. its `length` is the frame's samples.
+        template <typename Info>
+        class RenderAheadRing {
+        public:
+            enum {
+                block_size = 256,
+                max_starts = 2, // frames starting in one block
+                history = 16 // restarts the audio thread remembers
+            };
+            
+            struct Block {
+                std::int64_t position{0}; // stream sample of samples[0]
+                std::uint32_t generation{0};
+                std::size_t num_starts{0};
+                std::size_t start_offset[max_starts];
+                Info start_info[max_starts];
+                float samples[block_size];
+            };
+            
+            // room for ahead_samples rendered ahead, not while either side runs
+            void allocate(std::size_t ahead_samples) {
+                target = std::max<std::size_t>(1, (ahead_samples + block_size - 1) / block_size);
+                // stale blocks of the last generation wait in the queue until played past
+                const std::size_t count = 2 * target + 4;
+                blocks.assign(count, Block());
+                filled.reset(new SpscQueue<std::uint32_t>(count));
+                free_blocks.reset(new SpscQueue<std::uint32_t>(count));
+                for(std::size_t i = 0; i < count; ++i) free_blocks->push(static_cast<std::uint32_t>(i));
+                current = -1;
+                generation = 0;
+                worker_generation = 0;
+                restart_generation = 0;
+                played = 0;
+                has_played_start = false;
+                counted_from = std::numeric_limits<std::int64_t>::max();
+                underruns = 0;
+                std::fill(invalid_from, invalid_from + history, std::numeric_limits<std::int64_t>::max());
+                requested_generation = 1;
+            }
+            
+            bool isAllocated() const
+            { return !blocks.empty(); };
+            
+            // samples the worker keeps rendered ahead
+            std::size_t getAhead() const
+            { return target * block_size; };
+            
+            // from any thread
+            void requestRestart()
+            { requested_generation.fetch_add(1, std::memory_order_acq_rel); };
+            
+            // samples the audio thread had to fill with silence
+            std::uint64_t getUnderruns() const
+            { return underruns.load(std::memory_order_relaxed); };
+            
+            // audio thread: frames samples for stream position `position` into
+            // every stride'th float of out, on_start(position, info) for each
+            // frame starting among them. returns the samples that were ready.
+            template <typename OnStart>
+            std::size_t read(float *out, std::size_t frames, std::size_t stride, std::int64_t position, OnStart &&on_start) {
+                if(!isAllocated()) return 0;
+                const std::uint32_t requested = requested_generation.load(std::memory_order_acquire);
+                const std::int64_t until = position + static_cast<std::int64_t>(frames);
+                
+                std::size_t i = 0, missing = 0;
+                while(i < frames) {
+                    const std::int64_t at = position + static_cast<std::int64_t>(i);
+                    if(current < 0) {
+                        std::uint32_t index;
+                        if(!filled->pop(index)) break;
+                        current = index;
+                    }
+                    const Block &block = blocks[current];
+                    const std::int64_t end = std::min(block.position + static_cast<std::int64_t>(block_size), validUntil(block));
+                    if(end <= at) {
+                        // played past it already, or invalidated by a restart
+                        release();
+                        continue;
+                    }
+                    if(at < block.position) {
+                        const std::size_t gap = static_cast<std::size_t>(std::min<std::int64_t>(block.position - at, frames - i));
+                        for(std::size_t k = 0; k < gap; ++k) out[(i + k) * stride] = 0.0f;
+                        missing += gap;
+                        i += gap;
+                        continue;
+                    }
+                    const std::size_t from = static_cast<std::size_t>(at - block.position);
+                    const std::size_t n = static_cast<std::size_t>(std::min<std::int64_t>(end - at, frames - i));
+                    for(std::size_t k = 0; k < n; ++k) out[(i + k) * stride] = block.samples[from + k];
+                    for(std::size_t s = 0; s < block.num_starts; ++s) {
+                        const std::size_t offset = block.start_offset[s];
+                        if(offset < from || from + n <= offset) continue;
+                        on_start(block.position + static_cast<std::int64_t>(offset), block.start_info[s]);
+                        played_start = block.start_info[s];
+                        played_start_position = block.position + static_cast<std::int64_t>(offset);
+                        has_played_start = true;
+                    }
+                    i += n;
+                    if(block.position + static_cast<std::int64_t>(from + n) == end) release();
+                }
+                for(std::size_t k = i; k < frames; ++k) out[k * stride] = 0.0f;
+                missing += frames - i;
+                // nothing was due before the first generation started
+                if(missing && counted_from <= position) underruns.fetch_add(missing, std::memory_order_relaxed);
+                played.store(until, std::memory_order_release);
+                if(requested != generation) {
+                    // the frame playing is finished from the old blocks first
+                    std::int64_t from = until;
+                    if(has_played_start) from = std::max(from, played_start_position + played_start.length);
+                    // generations requested and replaced before a callback saw them
+                    // never played, blocks of the one before end there as well
+                    const std::uint32_t count = std::min<std::uint32_t>(requested - generation, history);
+                    for(std::uint32_t k = 0; k < count; ++k) invalid_from[(requested - k) % history] = from;
+                    generation = requested;
+                    counted_from = std::min(counted_from, from);
+                    // published once this callback is played, with the frame before it
+                    Restart &slot = restarts[generation % history];
+                    slot.position = from;
+                    slot.has_last = has_played_start;
+                    if(has_played_start) slot.last = played_start;
+                    restart_generation.store(generation, std::memory_order_release);
+                }
+                return frames - missing;
+            }
+            
+            // worker: true once when the audio thread has started a new
+            // generation, with the stream position to render it from and the
+            // last frame the audio thread played before it, nullptr if none
+            bool restarted(std::int64_t &position, const Info *&last_played) {
+                const std::uint32_t published = restart_generation.load(std::memory_order_acquire);
+                if(published == worker_generation) return false;
+                worker_generation = published;
+                const Restart &slot = restarts[published % history];
+                position = slot.position;
+                last_played = slot.has_last ? &slot.last : nullptr;
+                return true;
+            }
+            
+            // worker: the generation to stamp on blocks, 0 before the first restart
+            std::uint32_t getWorkerGeneration() const
+            { return worker_generation; };
+            
+            // worker: a free block for stream position `position`,
+            // if that is less than the target ahead of the audio thread
+            Block *acquire(std::int64_t position) {
+                if(!isAllocated()) return nullptr;
+                if(played.load(std::memory_order_acquire) + static_cast<std::int64_t>(getAhead()) <= position) return nullptr;
+                std::uint32_t index;
+                if(!free_blocks->pop(index)) return nullptr;
+                Block *block = &blocks[index];
+                block->position = position;
+                block->generation = worker_generation;
+                block->num_starts = 0;
+                return block;
+            }
+            
+            // worker: hands a block from acquire() to the audio thread
+            void commit(Block *block)
+            { filled->push(static_cast<std::uint32_t>(block - blocks.data())); };
+            
+        protected:
+            struct Restart {
+                std::int64_t position{0};
+                bool has_last{false};
+                Info last;
+            };
+            
+            // first stream position of block no longer valid after restarts
+            std::int64_t validUntil(const Block &block) const {
+                if(block.generation == generation) return std::numeric_limits<std::int64_t>::max();
+                if(history <= generation - block.generation) return std::numeric_limits<std::int64_t>::min();
+                return invalid_from[(block.generation + 1) % history];
+            }
+            
+            void release() {
+                free_blocks->push(static_cast<std::uint32_t>(current));
+                current = -1;
+            }
+            
+            std::vector<Block> blocks;
+            std::unique_ptr<SpscQueue<std::uint32_t>> filled; // worker -> audio thread
+            std::unique_ptr<SpscQueue<std::uint32_t>> free_blocks; // audio thread -> worker
+            std::size_t target{0}; // blocks rendered ahead
+            
+            // audio thread
+            std::int64_t current{-1}; // block being played
+            std::uint32_t generation{0};
+            std::int64_t invalid_from[history]; // by generation: where it replaced the previous one
+            std::int64_t counted_from; // underruns from here on
+            Info played_start; // of the last frame played
+            std::int64_t played_start_position{0};
+            bool has_played_start{false};
+            Restart restarts[history]; // by generation, read by the worker once published
+            
+            // worker
+            std::uint32_t worker_generation{0};
+            
+            std::atomic<std::uint32_t> requested_generation{0};
+            std::atomic<std::uint32_t> restart_generation{0};
+            std::atomic<std::int64_t> played{0}; // stream position the audio thread is done with
+            std::atomic<std::uint64_t> underruns{0};
+        };
+    };
+};
+
+#endif /* ofxLTC_RenderAhead_h */
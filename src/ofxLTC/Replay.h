@@ -0,0 +1,356 @@
+//
+//  Replay.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_Replay_h
+#define ofxLTC_Replay_h
+
+#include "../ofxLTC.h"
+#include "AudioFile.h"
+#include "CaptureLog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ofx {
+    namespace LTC {
+        // plays a recording or a capture log back into receivers in place of a
+        // sound stream, without a device and as fast as the CPU allows or paced
+        // at a multiple of real time.
+        //
+        // the audio comes from a WAV / BWF / RF64 or raw PCM file, or is encoded
+        // again from the frames of a capture log at their logged positions,
+        // lengths, directions and levels. buffer sizes and arrival times come from
+        // the buffers a capture log holds (Receiver::onBuffer into
+        // CaptureLogWriter::pushBuffer), otherwise buffers are buffer_size long
+        // and on time. receivers are fed through Receiver::process with the
+        // capture's stream positions and arrival times, so what they report does
+        // not depend on the replay speed.
+        class Replay {
+        public:
+            struct Settings {
+                double speed{0.0}; // 1: real time, 60: an hour a minute, 0: as fast as possible
+                std::size_t buffer_size{512}; // without logged buffers
+            };
+            
+            Replay() = default;
+            Replay(const Settings &settings)
+            : settings(settings) {};
+            
+            ~Replay()
+            { freeEncoder(); };
+            
+            void setup(const Settings &settings)
+            { this->settings = settings; };
+            
+            // audio from a WAV / BWF / RF64 file, all of its channels
+            bool openAudio(const std::string &path) {
+                close();
+                if(!audio.open(path)) return false;
+                sample_rate = audio.getSampleRate();
+                num_channels = audio.getNumChannels();
+                return true;
+            }
+            
+            bool openRaw(const std::string &path, AudioFile::Format format, std::size_t num_channels,
+                         double sample_rate, std::uint64_t offset = 0)
+            {
+                close();
+                if(!audio.openRaw(path, format, num_channels, sample_rate, offset)) return false;
+                this->sample_rate = sample_rate;
+                this->num_channels = num_channels;
+                return true;
+            }
+            
+            // one channel of LTC encoded from the frames of a capture log, rotated files
+            // in order. takes the buffer timing from the same log if it has any.
+            bool openLog(const std::vector<std::string> &paths) {
+                close();
+                CaptureEntry first;
+                if(!frames.open(paths, false, sample_rate) || !frames.next(first)) return false;
+                num_channels = 1;
+                pending_frame = first;
+                has_frame = true;
+                rendered_start = rendered_end = std::max<std::int64_t>(0, first.off_start - static_cast<std::int64_t>(sample_rate / 25.0));
+                time_base = first.time - (first.off_end + 1) / sample_rate;
+                has_time_base = true;
+                encoder = ltc_encoder_create(sample_rate, 25.0, LTC_TV_625_50, LTC_USE_DATE);
+                // room for a frame at a quarter speed
+                ltc_encoder_set_bufsize(encoder, sample_rate, 25.0 / 4);
+                openTiming(paths);
+                return true;
+            }
+            
+            // buffer sizes and arrival times from a capture log. false if it has none.
+            bool openTiming(const std::vector<std::string> &paths) {
+                double rate;
+                CaptureEntry first;
+                if(!timing.open(paths, true, rate) || !timing.next(first)) {
+                    timing.close();
+                    return false;
+                }
+                pending_block = first;
+                has_block = true;
+                return true;
+            }
+            
+            void close() {
+                audio.close();
+                frames.close();
+                timing.close();
+                freeEncoder();
+                has_frame = has_block = has_time_base = false;
+                rendered.clear();
+                rendered_start = rendered_end = 0;
+                position = 0;
+            }
+            
+            // the receiver decodes `channel` of the replayed buffers
+            void attach(Receiver &receiver, std::size_t channel = 0) {
+                if(num_channels <= channel) {
+                    ofLogError() << "[LTC] Replay has no channel " << channel;
+                    return;
+                }
+                receiver.setupDecoder(sample_rate, channel);
+                receivers.push_back(&receiver);
+            }
+            
+            void detach(Receiver &receiver)
+            { receivers.erase(std::remove(receivers.begin(), receivers.end(), &receiver), receivers.end()); };
+            
+            // plays until the end, stop() or `max_samples` sample frames, on the calling thread.
+            // returns the number of sample frames played.
+            std::int64_t run(std::int64_t max_samples = -1) {
+                stopped = false;
+                std::int64_t played = 0;
+                const double start = getMonotonicTime();
+                bool first = true;
+                double first_arrival = 0.0;
+                Block block;
+                while(!stopped.load() && (max_samples < 0 || played < max_samples) && nextBlock(block)) {
+                    fill(block);
+                    if(first) {
+                        first_arrival = block.arrival;
+                        first = false;
+                    }
+                    if(0.0 < settings.speed) {
+                        const double due = start + (block.arrival - first_arrival) / settings.speed;
+                        const double wait = due - getMonotonicTime();
+                        if(0.0 < wait) std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+                    }
+                    for(auto receiver : receivers) {
+                        receiver->process(buffer, block.position, block.arrival);
+                    }
+                    played += block.frames;
+                }
+                return played;
+            }
+            
+            // from any thread, run() returns after the current buffer
+            void stop()
+            { stopped = true; };
+            
+            double getSampleRate() const
+            { return sample_rate; };
+            
+            std::size_t getNumChannels() const
+            { return num_channels; };
+            
+            // stream position of the next buffer
+            std::int64_t getPosition() const
+            { return position; };
+            
+        protected:
+            struct Block {
+                std::int64_t position; // stream position handed to the receivers
+                std::int64_t source; // sample frame of the audio file or the log
+                std::size_t frames;
+                double arrival;
+            };
+            
+            // the entries of one kind from rotated capture log files
+            struct LogCursor {
+                bool open(const std::vector<std::string> &paths, bool buffers, double &sample_rate) {
+                    this->paths = paths;
+                    this->buffers = buffers;
+                    file = 0;
+                    opened = false;
+                    if(paths.empty() || !reader.open(paths.front())) return false;
+                    sample_rate = reader.getSampleRate();
+                    file = 1;
+                    opened = true;
+                    return true;
+                }
+                
+                void close() {
+                    paths.clear();
+                    opened = false;
+                }
+                
+                bool isOpen() const
+                { return !paths.empty(); };
+                
+                bool next(CaptureEntry &entry) {
+                    while(true) {
+                        if(!opened) {
+                            if(paths.size() <= file) return false;
+                            opened = reader.open(paths[file++]);
+                            continue;
+                        }
+                        while(reader.next(entry)) {
+                            // the flywheel's frames weren't in the signal
+                            if(entry.buffer == buffers && !entry.extrapolated) return true;
+                        }
+                        opened = false;
+                    }
+                }
+                
+                std::vector<std::string> paths;
+                std::size_t file{0};
+                CaptureLogReader reader;
+                bool opened{false};
+                bool buffers{false};
+            };
+            
+            bool nextBlock(Block &block) {
+                const bool from_log = frames.isOpen();
+                if(timing.isOpen()) {
+                    if(!has_block) return false;
+                    block.frames = static_cast<std::size_t>(pending_block.off_end - pending_block.off_start + 1);
+                    block.arrival = pending_block.time;
+                    // a recording starts with the first buffer, a log plays at its own positions
+                    block.position = from_log ? pending_block.off_start : position;
+                    has_block = timing.next(pending_block);
+                } else {
+                    if(!has_time_base) {
+                        time_base = getMonotonicTime();
+                        has_time_base = true;
+                    }
+                    block.frames = settings.buffer_size;
+                    block.position = from_log ? std::max(position, rendered_start) : position;
+                    block.arrival = time_base + (block.position + settings.buffer_size) / sample_rate;
+                }
+                block.source = from_log ? block.position : position;
+                if(!from_log && audio.getNumFrames() <= block.source) return false;
+                // without logged buffers a log ends with its last frame
+                if(from_log && !timing.isOpen() && !has_frame && rendered_end <= block.position) return false;
+                position = block.position + static_cast<std::int64_t>(block.frames);
+                return true;
+            }
+            
+            // 0.0, like silence recorded from a device
+            enum : ltcsnd_sample_t { quiet = 127 };
+            
+            // libltc samples go through Receiver's 8 bit conversion unchanged
+            static float toFloat(ltcsnd_sample_t sample)
+            { return (sample + 0.5f) / 127.5f - 1.0f; };
+            
+            void fill(const Block &block) {
+                buffer.allocate(block.frames, num_channels);
+                buffer.setSampleRate(sample_rate);
+                std::vector<float> &out = buffer.getBuffer();
+                if(frames.isOpen()) {
+                    render(block.position, block.frames);
+                    const std::size_t skip = static_cast<std::size_t>(block.position - rendered_start);
+                    for(std::size_t i = 0; i < block.frames; ++i) out[i] = toFloat(rendered[skip + i]);
+                    return;
+                }
+                samples.resize(block.frames);
+                for(std::size_t c = 0; c < num_channels; ++c) {
+                    const std::size_t got = audio.read(block.source, block.frames, c, samples.data());
+                    std::fill(samples.begin() + got, samples.end(), quiet);
+                    for(std::size_t i = 0; i < block.frames; ++i) out[i * num_channels + c] = toFloat(samples[i]);
+                }
+            }
+            
+            // encodes logged frames until [position, position + count) is covered.
+            // each frame is stretched to end where it ended in the capture.
+            void render(std::int64_t position, std::size_t count) {
+                if(rendered_end <= position) {
+                    rendered.clear();
+                    rendered_start = rendered_end = position;
+                } else if(rendered_start < position) {
+                    rendered.erase(rendered.begin(), rendered.begin() + static_cast<std::size_t>(position - rendered_start));
+                    rendered_start = position;
+                }
+                const std::int64_t end = position + static_cast<std::int64_t>(count);
+                const double nominal = sample_rate / 25.0;
+                while(rendered_end < end) {
+                    if(!has_frame) {
+                        silence(end);
+                        break;
+                    }
+                    const CaptureEntry &f = pending_frame;
+                    // a dropout
+                    if(rendered_end < f.off_start) silence(f.off_start);
+                    const double speed = (f.off_end + 1 - rendered_end) / nominal;
+                    if(0.25 <= speed && speed <= 4.0) {
+                        LTCFrame frame = f.frame();
+                        ltc_encoder_set_frame(encoder, &frame);
+                        ltc_encoder_set_volume(encoder, std::max(-42.0, std::min(0.0, static_cast<double>(f.volume))));
+                        for(int i = 0; i < LTC_FRAME_BIT_COUNT / 8; ++i) {
+                            if(f.reverse) ltc_encoder_encode_byte(encoder, LTC_FRAME_BIT_COUNT / 8 - 1 - i, -speed);
+                            else ltc_encoder_encode_byte(encoder, i, speed);
+                        }
+                        int size = 0;
+                        ltcsnd_sample_t *data = ltc_encoder_get_bufptr(encoder, &size, 1);
+                        rendered.insert(rendered.end(), data, data + size);
+                        rendered_end += size;
+                        half_bit = std::max<std::int64_t>(1, (f.off_end - f.off_start + 1) / (2 * LTC_FRAME_BIT_COUNT));
+                    }
+                    has_frame = frames.next(pending_frame);
+                }
+            }
+            
+            // silence up to `until`. the decoder only completes a frame on the
+            // edge after it, which the capture had from the signal that followed.
+            void silence(std::int64_t until) {
+                if(!rendered.empty() && rendered.back() != quiet) {
+                    const std::int64_t edge = std::min(until - rendered_end, half_bit);
+                    rendered.resize(rendered.size() + static_cast<std::size_t>(edge), 256 - rendered.back());
+                    rendered_end += edge;
+                }
+                rendered.resize(rendered.size() + static_cast<std::size_t>(until - rendered_end), quiet);
+                rendered_end = until;
+            }
+            
+            void freeEncoder() {
+                if(encoder) ltc_encoder_free(encoder);
+                encoder = nullptr;
+            }
+            
+            Settings settings;
+            std::vector<Receiver *> receivers;
+            double sample_rate{48000.0};
+            std::size_t num_channels{0};
+            std::int64_t position{0}; // next stream position
+            ofSoundBuffer buffer;
+            std::atomic<bool> stopped{false};
+            
+            AudioFile audio;
+            std::vector<ltcsnd_sample_t> samples;
+            
+            LogCursor frames;
+            CaptureEntry pending_frame;
+            bool has_frame{false};
+            LTCEncoder *encoder{nullptr};
+            std::vector<ltcsnd_sample_t> rendered; // encoded samples from rendered_start on
+            std::int64_t rendered_start{0};
+            std::int64_t rendered_end{0};
+            std::int64_t half_bit{12}; // of the last frame encoded
+            
+            LogCursor timing;
+            CaptureEntry pending_block;
+            bool has_block{false};
+            double time_base{0.0}; // arrival of stream position 0 without logged buffers
+            bool has_time_base{false};
+        };
+    };
+};
+
+#endif /* ofxLTC_Replay_h */
@@ -0,0 +1,55 @@
+//
+//  SampleClock.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_SampleClock_h
+#define ofxLTC_SampleClock_h
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace ofx {
+    namespace LTC {
+        // seconds on std::chrono::steady_clock, the clock all frame timestamps refer to
+        inline double getMonotonicTime() {
+            using namespace std::chrono;
+            return duration<double>(steady_clock::now().time_since_epoch()).count();
+        }
+        
+        // maps stream sample positions to monotonic time.
+        // a sound callback fires once its buffer is complete, so
+        // arrival - position / rate estimates when sample 0 passed the converter.
+        // callbacks are only ever late, so earlier estimates are followed at once
+        // and later ones slowly, which absorbs scheduling jitter but tracks drift.
+        struct SampleClock {
+            void reset(double sample_rate) {
+                this->sample_rate = sample_rate;
+                has_epoch = false;
+            }
+            
+            void update(double arrival, std::int64_t end_position) {
+                const double candidate = arrival - end_position / sample_rate;
+                if(!has_epoch || 0.5 < std::abs(candidate - epoch)) {
+                    epoch = candidate;
+                    has_epoch = true;
+                } else if(candidate < epoch) {
+                    epoch = candidate;
+                } else {
+                    epoch += (candidate - epoch) * 0.01;
+                }
+            }
+            
+            double timeOf(std::int64_t position) const
+            { return epoch + position / sample_rate + latency; };
+            
+            double sample_rate{48000.0};
+            double epoch{0.0}; // monotonic time of stream sample 0
+            double latency{0.0}; // signed device latency offset added to every reported time
+            bool has_epoch{false};
+        };
+    };
+};
+
+#endif /* ofxLTC_SampleClock_h */
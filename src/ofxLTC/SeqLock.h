@@ -0,0 +1,64 @@
+//
+//  SeqLock.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_SeqLock_h
+#define ofxLTC_SeqLock_h
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ofx {
+    namespace LTC {
+        // single writer, any number of readers. readers never block the writer,
+        // they retry if a store happened while they were copying.
+        // the payload is kept in atomic words so concurrent access is well defined.
+        template <typename T>
+        class SeqLock {
+            static_assert(std::is_trivially_copyable<T>::value,
+                          "SeqLock payload must be trivially copyable");
+            static constexpr std::size_t word_count = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+        public:
+            SeqLock() { store(T{}); }
+            explicit SeqLock(const T &value) { store(value); }
+            
+            void store(const T &value) {
+                std::uint64_t words[word_count] = {};
+                std::memcpy(words, &value, sizeof(T));
+                
+                const std::uint32_t seq = sequence.load(std::memory_order_relaxed);
+                sequence.store(seq + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                for(std::size_t i = 0; i < word_count; ++i) {
+                    data[i].store(words[i], std::memory_order_relaxed);
+                }
+                sequence.store(seq + 2, std::memory_order_release);
+            }
+            
+            T load() const {
+                std::uint64_t words[word_count];
+                std::uint32_t seq;
+                do {
+                    seq = sequence.load(std::memory_order_acquire);
+                    for(std::size_t i = 0; i < word_count; ++i) {
+                        words[i] = data[i].load(std::memory_order_relaxed);
+                    }
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                } while((seq & 1u) || seq != sequence.load(std::memory_order_relaxed));
+                
+                T value;
+                std::memcpy(&value, words, sizeof(T));
+                return value;
+            }
+            
+        private:
+            std::atomic<std::uint32_t> sequence{0};
+            std::atomic<std::uint64_t> data[word_count];
+        };
+    };
+};
+
+#endif /* ofxLTC_SeqLock_h */
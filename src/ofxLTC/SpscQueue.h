@@ -0,0 +1,78 @@
+//
+//  SpscQueue.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_SpscQueue_h
+#define ofxLTC_SpscQueue_h
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace ofx {
+    namespace LTC {
+        // bounded single producer / single consumer queue. push and pop never
+        // block or allocate, so the producer may be an audio callback.
+        // capacity is rounded up to a power of two.
+        template <typename T>
+        class SpscQueue {
+            static_assert(std::is_trivially_copyable<T>::value,
+                          "SpscQueue elements must be trivially copyable");
+        public:
+            explicit SpscQueue(std::size_t capacity = 1024) {
+                std::size_t size = 2;
+                while(size < capacity) size *= 2;
+                slots.resize(size);
+                mask = size - 1;
+            }
+            
+            // false if the queue is full
+            bool push(const T &value) {
+                const std::size_t tail = write_index.load(std::memory_order_relaxed);
+                if(tail - cached_read == slots.size()) {
+                    cached_read = read_index.load(std::memory_order_acquire);
+                    if(tail - cached_read == slots.size()) return false;
+                }
+                slots[tail & mask] = value;
+                write_index.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+            
+            // false if the queue is empty
+            bool pop(T &value) {
+                const std::size_t head = read_index.load(std::memory_order_relaxed);
+                if(head == cached_write) {
+                    cached_write = write_index.load(std::memory_order_acquire);
+                    if(head == cached_write) return false;
+                }
+                value = slots[head & mask];
+                read_index.store(head + 1, std::memory_order_release);
+                return true;
+            }
+            
+            // approximate from any thread other than the two using it
+            std::size_t size() const
+            { return write_index.load(std::memory_order_acquire) - read_index.load(std::memory_order_acquire); };
+            
+            std::size_t capacity() const
+            { return slots.size(); };
+            
+        private:
+            std::vector<T> slots;
+            std::size_t mask;
+            
+            // producer and consumer side on their own cache lines
+            char padding0[64];
+            std::atomic<std::size_t> write_index{0};
+            std::size_t cached_read{0};
+            char padding1[64];
+            std::atomic<std::size_t> read_index{0};
+            std::size_t cached_write{0};
+            char padding2[64];
+        };
+    };
+};
+
+#endif /* ofxLTC_SpscQueue_h */
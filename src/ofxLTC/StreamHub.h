@@ -0,0 +1,101 @@
+//
+//  StreamHub.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_StreamHub_h
+#define ofxLTC_StreamHub_h
+
+#include "../ofxLTC.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ofx {
+    namespace LTC {
+        // owns one input ofSoundStream and fans every callback out to any number
+        // of receivers, each bound to its own channel. all of them see the same
+        // buffer, stream position and arrival time, so their timestamps agree.
+        // each receiver does a single strided read of its channel, nothing else is copied.
+        class StreamHub {
+        public:
+            ~StreamHub() {
+                soundStream.close();
+            }
+            
+            void setup(const ofSoundStreamSettings &settings) {
+                ofSoundStreamSettings settings_ = settings;
+                settings_.setInListener(this);
+                sample_rate = settings_.sampleRate;
+                num_channels = settings_.numInputChannels;
+                position = 0;
+                soundStream.setup(settings_);
+            }
+            
+            // receiver owned by the hub
+            Receiver &addReceiver(std::size_t channel) {
+                std::unique_ptr<Receiver> receiver(new Receiver);
+                Receiver &ref = *receiver;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    owned.push_back(std::move(receiver));
+                }
+                attach(ref, channel);
+                return ref;
+            }
+            
+            // receiver owned by the caller, it must outlive the hub or be detached
+            void attach(Receiver &receiver, std::size_t channel) {
+                if(num_channels <= channel) {
+                    ofLogError() << "[LTC] StreamHub has no input channel " << channel;
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                receiver.setupDecoder(sample_rate, channel);
+                receivers.push_back(&receiver);
+            }
+            
+            void detach(Receiver &receiver) {
+                std::lock_guard<std::mutex> lock(mutex);
+                receivers.erase(std::remove(receivers.begin(), receivers.end(), &receiver), receivers.end());
+            }
+            
+            void audioIn(ofSoundBuffer &buffer) {
+                const double arrival = getMonotonicTime();
+                std::lock_guard<std::mutex> lock(mutex);
+                for(auto receiver : receivers) {
+                    receiver->process(buffer, position, arrival);
+                }
+                position += buffer.getNumFrames();
+            }
+            
+            double getSampleRate() const
+            { return sample_rate; };
+            
+            std::size_t getNumChannels() const
+            { return num_channels; };
+            
+            std::int64_t getPosition() const
+            { return position.load(); };
+            
+            std::vector<ofSoundDevice> getDeivceList() const
+            { return soundStream.getDeviceList(); };
+            
+        protected:
+            ofSoundStream soundStream;
+            std::mutex mutex;
+            std::vector<Receiver *> receivers;
+            std::vector<std::unique_ptr<Receiver>> owned;
+            double sample_rate{48000.0};
+            std::size_t num_channels{0ul};
+            std::atomic<std::int64_t> position{0};
+        };
+    };
+};
+
+using ofxLTCStreamHub = ofx::LTC::StreamHub;
+
+#endif /* ofxLTC_StreamHub_h */
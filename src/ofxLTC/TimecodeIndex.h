@@ -0,0 +1,374 @@
+//
+//  TimecodeIndex.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_TimecodeIndex_h
+#define ofxLTC_TimecodeIndex_h
+
+#include "ltc.h"
+#include "FrameCount.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace ofx {
+    namespace LTC {
+        // maps timecode to sample offsets of a recording and back.
+        // the file is a Header, the continuous runs of timecode in recording
+        // order and a priority search tree over the runs' label ranges, all
+        // fixed size little endian records, so it is used memory mapped as is.
+        // labels are frame counts since midnight, see toFrameCount().
+        // does not depend on openFrameworks.
+        class TimecodeIndex {
+        public:
+            static constexpr std::uint32_t version = 2;
+            
+            struct Header {
+                char magic[4]; // "LTCI"
+                std::uint32_t version;
+                double sample_rate;
+                std::uint32_t fps;
+                std::uint32_t num_runs;
+                std::uint64_t reserved;
+            };
+            
+            // frames with consecutive labels and evenly spaced off_start
+            struct Run {
+                std::int64_t sample; // off_start of the first frame
+                double samples_per_frame;
+                std::int32_t label; // of the first frame
+                std::int32_t length; // frames
+                std::int8_t direction; // 1, or -1 for reverse play
+                std::uint8_t drop_frame;
+                std::uint16_t reserved0;
+                std::uint32_t reserved1;
+                
+                std::int64_t lowLabel() const
+                { return direction < 0 ? label - length + 1 : label; };
+                
+                std::int64_t highLabel() const // exclusive
+                { return lowLabel() + length; };
+            };
+            
+            // node i of an implicit binary tree, children at 2i+1 and 2i+2.
+            // no entry in the subtree has a larger high (heap order), and the
+            // lows of the left subtree are <= those of the right subtree.
+            struct LabelEntry {
+                std::int32_t low;
+                std::int32_t high; // exclusive
+                std::int32_t min_low; // the smallest low in the subtree
+                std::uint32_t run;
+            };
+            
+            struct Position {
+                std::size_t run;
+                std::int64_t label;
+                double phase; // 0..1 into the frame
+                bool drop_frame;
+                bool reverse;
+            };
+            
+            TimecodeIndex() = default;
+            TimecodeIndex(const TimecodeIndex &) = delete;
+            TimecodeIndex &operator=(const TimecodeIndex &) = delete;
+            ~TimecodeIndex()
+            { close(); };
+            
+            bool open(const std::string &path) {
+                close();
+#ifndef _WIN32
+                const int fd = ::open(path.c_str(), O_RDONLY);
+                if(0 <= fd) {
+                    struct stat st;
+                    if(fstat(fd, &st) == 0 && 0 < st.st_size) {
+                        void *p = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                        if(p != MAP_FAILED) {
+                            mapped = p;
+                            mapped_size = static_cast<std::size_t>(st.st_size);
+                        }
+                    }
+                    ::close(fd);
+                    if(mapped) return attach(static_cast<const unsigned char *>(mapped), mapped_size);
+                }
+#endif
+                std::FILE *file = std::fopen(path.c_str(), "rb");
+                if(!file) return false;
+                std::vector<unsigned char> bytes;
+                unsigned char block[1 << 16];
+                for(std::size_t n; (n = std::fread(block, 1, sizeof(block), file)) != 0;) {
+                    bytes.insert(bytes.end(), block, block + n);
+                }
+                std::fclose(file);
+                return assign(std::move(bytes));
+            }
+            
+            // an index kept in memory, e.g. from TimecodeIndexBuilder::bytes()
+            bool assign(std::vector<unsigned char> bytes) {
+                close();
+                owned = std::move(bytes);
+                return attach(owned.data(), owned.size());
+            }
+            
+            void close() {
+#ifndef _WIN32
+                if(mapped) munmap(mapped, mapped_size);
+#endif
+                mapped = nullptr;
+                mapped_size = 0;
+                owned.clear();
+                header = nullptr;
+                runs = nullptr;
+                by_label = nullptr;
+            }
+            
+            bool isOpen() const
+            { return header != nullptr; };
+            
+            double getSampleRate() const
+            { return header ? header->sample_rate : 0.0; };
+            
+            int getFps() const
+            { return header ? static_cast<int>(header->fps) : 0; };
+            
+            std::size_t getNumRuns() const
+            { return header ? header->num_runs : 0; };
+            
+            const Run &getRun(std::size_t i) const
+            { return runs[i]; };
+            
+            // the frame playing at `sample`, false in between runs
+            bool timecodeAt(std::int64_t sample, Position &position) const {
+                if(!isOpen() || header->num_runs == 0) return false;
+                const Run *end = runs + header->num_runs;
+                const Run *run = std::upper_bound(runs, end, sample, [](std::int64_t s, const Run &r) { return s < r.sample; });
+                if(run == runs) return false;
+                --run;
+                const double frames = (sample - run->sample) / run->samples_per_frame;
+                const std::int64_t k = static_cast<std::int64_t>(std::floor(frames));
+                if(run->length <= k) return false;
+                position.run = static_cast<std::size_t>(run - runs);
+                position.label = run->label + run->direction * k;
+                position.phase = frames - k;
+                position.drop_frame = run->drop_frame != 0;
+                position.reverse = run->direction < 0;
+                return true;
+            }
+            
+            // off_start of every occurrence of `label` in recording order,
+            // appended to `samples`. returns the number found.
+            // O(log n + k) for k occurrences among n runs.
+            std::size_t samplesAt(std::int64_t label, std::vector<std::int64_t> &samples) const {
+                if(!isOpen()) return 0;
+                const std::size_t before = samples.size();
+                collect(0, label, samples);
+                std::sort(samples.begin() + before, samples.end());
+                return samples.size() - before;
+            }
+            
+            std::size_t samplesAt(int hour, int min, int sec, int frame, bool drop_frame,
+                                  std::vector<std::int64_t> &samples) const
+            { return samplesAt(toFrameCount(hour, min, sec, frame, getFps(), drop_frame), samples); };
+            
+        protected:
+            // the runs containing `label` at and below node i. a subtree whose
+            // lows all lie above label or whose highs all lie at or below it
+            // is skipped, so besides the k found this only visits the search
+            // path for label and the children of nodes visited.
+            void collect(std::size_t i, std::int64_t label, std::vector<std::int64_t> &samples) const {
+                if(header->num_runs <= i) return;
+                const LabelEntry &entry = by_label[i];
+                if(entry.high <= label || label < entry.min_low) return;
+                if(entry.low <= label) {
+                    const Run &run = runs[entry.run];
+                    const std::int64_t k = run.direction * (label - run.label);
+                    samples.push_back(run.sample + std::llround(k * run.samples_per_frame));
+                }
+                collect(2 * i + 1, label, samples);
+                collect(2 * i + 2, label, samples);
+            }
+            
+            bool attach(const unsigned char *data, std::size_t size) {
+                if(size < sizeof(Header)) return fail();
+                header = reinterpret_cast<const Header *>(data);
+                if(std::memcmp(header->magic, "LTCI", 4) || header->version != version) return fail();
+                const std::size_t n = header->num_runs;
+                if(size < sizeof(Header) + n * (sizeof(Run) + sizeof(LabelEntry))) return fail();
+                runs = reinterpret_cast<const Run *>(data + sizeof(Header));
+                by_label = reinterpret_cast<const LabelEntry *>(data + sizeof(Header) + n * sizeof(Run));
+                return true;
+            }
+            
+            bool fail() {
+                close();
+                return false;
+            }
+            
+            void *mapped{nullptr};
+            std::size_t mapped_size{0};
+            std::vector<unsigned char> owned;
+            const Header *header{nullptr};
+            const Run *runs{nullptr};
+            const LabelEntry *by_label{nullptr};
+        };
+        static_assert(sizeof(TimecodeIndex::Header) == 32, "TimecodeIndex::Header is written as is");
+        static_assert(sizeof(TimecodeIndex::Run) == 32, "TimecodeIndex::Run is written as is");
+        static_assert(sizeof(TimecodeIndex::LabelEntry) == 16, "TimecodeIndex::LabelEntry is written as is");
+        
+        // collects decoded frames in stream order into TimecodeIndex runs.
+        // a frame extends the current run if its label follows on in the same
+        // direction and its off_start is within `tolerance` samples of where
+        // the run predicts it, by default a quarter bit, which covers the few
+        // samples off_start jitters by. runs are split at midnight.
+        class TimecodeIndexBuilder {
+        public:
+            // fps 0 guesses 24, 25 or 30 from the length of the first frame
+            TimecodeIndexBuilder(double sample_rate, int fps = 0, double tolerance = 0.0)
+            : sample_rate(sample_rate)
+            , fps(fps)
+            , tolerance(tolerance)
+            {};
+            
+            void add(const LTCFrameExt &f) {
+                if(fps <= 0) fps = guessFps(f);
+                LTCFrame ltc = f.ltc;
+                const bool drop_frame = ltc.dfbit != 0;
+                const std::int64_t label = toFrameCount(ltc, fps);
+                const std::int8_t direction = f.reverse ? -1 : 1;
+                if(label < 0 || framesPerDay(fps, drop_frame) <= label) return;
+                
+                if(!runs.empty()) {
+                    TimecodeIndex::Run &run = runs.back();
+                    const std::int64_t next = run.label + run.direction * static_cast<std::int64_t>(run.length);
+                    if(run.direction == direction && (run.drop_frame != 0) == drop_frame && label == next) {
+                        // a single frame only knows its own length, allow for that being off a little
+                        const double predicted = run.sample + run.length * run.samples_per_frame;
+                        double slack = 0.0 < tolerance ? tolerance : run.samples_per_frame / (4 * LTC_FRAME_BIT_COUNT);
+                        if(run.length == 1) slack += 0.02 * run.samples_per_frame;
+                        if(std::fabs(f.off_start - predicted) <= slack) {
+                            ++run.length;
+                            run.samples_per_frame = static_cast<double>(f.off_start - run.sample) / (run.length - 1);
+                            return;
+                        }
+                    }
+                }
+                
+                TimecodeIndex::Run run;
+                std::memset(&run, 0, sizeof(run));
+                run.sample = f.off_start;
+                run.samples_per_frame = static_cast<double>(f.off_end - f.off_start + 1);
+                run.label = static_cast<std::int32_t>(label);
+                run.length = 1;
+                run.direction = direction;
+                run.drop_frame = drop_frame;
+                runs.push_back(run);
+            }
+            
+            std::size_t getNumRuns() const
+            { return runs.size(); };
+            
+            int getFps() const
+            { return fps; };
+            
+            // the index file's contents
+            std::vector<unsigned char> bytes() const {
+                TimecodeIndex::Header header;
+                std::memset(&header, 0, sizeof(header));
+                std::memcpy(header.magic, "LTCI", 4);
+                header.version = TimecodeIndex::version;
+                header.sample_rate = sample_rate;
+                header.fps = static_cast<std::uint32_t>(std::max(fps, 0));
+                header.num_runs = static_cast<std::uint32_t>(runs.size());
+                
+                std::vector<TimecodeIndex::LabelEntry> entries(runs.size());
+                for(std::size_t i = 0; i < runs.size(); ++i) {
+                    entries[i].low = static_cast<std::int32_t>(runs[i].lowLabel());
+                    entries[i].high = static_cast<std::int32_t>(runs[i].highLabel());
+                    entries[i].run = static_cast<std::uint32_t>(i);
+                }
+                std::stable_sort(entries.begin(), entries.end(), [](const TimecodeIndex::LabelEntry &a, const TimecodeIndex::LabelEntry &b) {
+                    return a.low < b.low;
+                });
+                std::vector<TimecodeIndex::LabelEntry> by_label(entries.size());
+                std::vector<std::size_t> sizes(entries.size());
+                for(std::size_t i = entries.size(); i-- != 0;) {
+                    const std::size_t left = 2 * i + 1, right = 2 * i + 2;
+                    sizes[i] = 1 + (left < entries.size() ? sizes[left] : 0) + (right < entries.size() ? sizes[right] : 0);
+                }
+                buildTree(0, entries, 0, entries.size(), sizes, by_label);
+                
+                std::vector<unsigned char> out(sizeof(header) + runs.size() * sizeof(TimecodeIndex::Run)
+                                               + by_label.size() * sizeof(TimecodeIndex::LabelEntry));
+                unsigned char *p = out.data();
+                std::memcpy(p, &header, sizeof(header));
+                p += sizeof(header);
+                if(!runs.empty()) {
+                    std::memcpy(p, runs.data(), runs.size() * sizeof(TimecodeIndex::Run));
+                    p += runs.size() * sizeof(TimecodeIndex::Run);
+                    std::memcpy(p, by_label.data(), by_label.size() * sizeof(TimecodeIndex::LabelEntry));
+                }
+                return out;
+            }
+            
+            bool write(const std::string &path) const {
+                const std::vector<unsigned char> data = bytes();
+                std::FILE *file = std::fopen(path.c_str(), "wb");
+                if(!file) return false;
+                const bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+                return std::fclose(file) == 0 && ok;
+            }
+            
+        protected:
+            // node i of the priority search tree from entries[first, last),
+            // which are sorted by low and get reordered in place
+            static void buildTree(std::size_t i, std::vector<TimecodeIndex::LabelEntry> &entries,
+                                  std::size_t first, std::size_t last, const std::vector<std::size_t> &sizes,
+                                  std::vector<TimecodeIndex::LabelEntry> &tree) {
+                if(first == last) return;
+                const std::int32_t min_low = entries[first].low;
+                std::size_t top = first;
+                for(std::size_t j = first + 1; j < last; ++j) {
+                    if(entries[top].high < entries[j].high) top = j;
+                }
+                // keep the rest sorted by low
+                std::rotate(entries.begin() + first, entries.begin() + top, entries.begin() + top + 1);
+                TimecodeIndex::LabelEntry node = entries[first];
+                const std::size_t left = 2 * i + 1;
+                const std::size_t middle = first + 1 + (left < tree.size() ? sizes[left] : 0);
+                node.min_low = min_low;
+                tree[i] = node;
+                buildTree(left, entries, first + 1, middle, sizes, tree);
+                buildTree(left + 1, entries, middle, last, sizes, tree);
+            }
+            
+            int guessFps(const LTCFrameExt &f) const {
+                const double measured = sample_rate / (f.off_end - f.off_start + 1);
+                int best = 25;
+                for(int candidate : {24, 25, 30}) {
+                    if(std::fabs(measured - candidate) < std::fabs(measured - best)) best = candidate;
+                }
+                return best;
+            }
+            
+            double sample_rate;
+            int fps;
+            double tolerance;
+            std::vector<TimecodeIndex::Run> runs;
+        };
+    };
+};
+
+#endif /* ofxLTC_TimecodeIndex_h */
@@ -0,0 +1,47 @@
+//
+//  TimecodeSnapshot.h
+//  ofxLTC
+//
+
+#ifndef ofxLTC_TimecodeSnapshot_h
+#define ofxLTC_TimecodeSnapshot_h
+
+#include "ltc.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ofx {
+    namespace LTC {
+        // the fields of a Timecode, trivially copyable: the timezone is kept
+        // in place instead of in a std::string. this is what the audio thread
+        // publishes through a SeqLock and passes around in render-ahead blocks,
+        // without allocating. makeSnapshot / makeTimecode in ofxLTC.h convert.
+        struct TimecodeSnapshot {
+            LTCFrameExt raw_data;
+            char timezone[6]; // as in SMPTETimecode, nul terminated
+            std::uint16_t year;
+            std::uint8_t month;
+            std::uint8_t day;
+            std::uint8_t hour;
+            std::uint8_t min;
+            std::uint8_t sec;
+            std::uint8_t frame;
+            bool reverse;
+            bool extrapolated;
+            float receivedTime;
+            std::int64_t samplePosition;
+            double monotonicTime;
+            
+            void setTimezone(const char *zone) {
+                const std::size_t length = std::min(std::strlen(zone), sizeof(timezone) - 1);
+                std::memcpy(timezone, zone, length);
+                timezone[length] = '\0';
+            }
+        };
+    };
+};
+
+#endif /* ofxLTC_TimecodeSnapshot_h */
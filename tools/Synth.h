@@ -0,0 +1,73 @@
+//
+//  Synth.h
+//  ofxLTC tools
+//
+//  synthetic LTC audio for the benchmarks
+//
+
+#ifndef ofxLTC_tools_Synth_h
+#define ofxLTC_tools_Synth_h
+
+#include "ltc.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace synth {
+    // `frames` consecutive LTC frames from 10:00:00:00 as float samples
+    inline std::vector<float> ltc(std::size_t frames, double sample_rate = 48000.0, double fps = 25.0) {
+        LTCEncoder *encoder = ltc_encoder_create(sample_rate, fps, fps == 25.0 ? LTC_TV_625_50 : LTC_TV_525_60, LTC_USE_DATE);
+        SMPTETimecode t;
+        std::memset(&t, 0, sizeof(t));
+        std::strcpy(t.timezone, "+0000");
+        t.years = 26;
+        t.months = 1;
+        t.days = 1;
+        t.hours = 10;
+        ltc_encoder_set_timecode(encoder, &t);
+        
+        std::vector<float> out;
+        out.reserve(static_cast<std::size_t>(frames * (sample_rate / fps + 1)));
+        for(std::size_t i = 0; i < frames; ++i) {
+            ltc_encoder_encode_frame(encoder);
+            int size = 0;
+            const ltcsnd_sample_t *buf = ltc_encoder_get_bufptr(encoder, &size, 1);
+            for(int k = 0; k < size; ++k) out.push_back((buf[k] - 128) / 127.0f);
+            ltc_encoder_inc_timecode(encoder);
+        }
+        ltc_encoder_free(encoder);
+        return out;
+    }
+    
+    // `in` played at 1 + depth * sin(2 pi t / period) times the speed, linearly
+    // interpolated, plus white noise of peak `noise`. repeatable.
+    inline std::vector<float> varispeed(const std::vector<float> &in, double depth, double period,
+                                        float noise, double sample_rate = 48000.0)
+    {
+        std::vector<float> out;
+        out.reserve(static_cast<std::size_t>(in.size() / (1.0 - depth)) + 1);
+        std::uint32_t seed = 1;
+        double pos = 0.0;
+        for(std::size_t i = 0; pos + 1.0 < in.size(); ++i) {
+            const std::size_t k = static_cast<std::size_t>(pos);
+            const float frac = static_cast<float>(pos - k);
+            seed = seed * 1664525u + 1013904223u;
+            out.push_back(in[k] + (in[k + 1] - in[k]) * frac + noise * ((seed >> 8) / 8388608.0f - 1.0f));
+            pos += 1.0 + depth * std::sin(2.0 * M_PI * i / (period * sample_rate));
+        }
+        return out;
+    }
+    
+    // the same signal on every channel, interleaved
+    inline std::vector<float> interleave(const std::vector<float> &mono, std::size_t channels) {
+        std::vector<float> out(mono.size() * channels);
+        for(std::size_t i = 0; i < mono.size(); ++i) {
+            for(std::size_t c = 0; c < channels; ++c) out[i * channels + c] = mono[i];
+        }
+        return out;
+    }
+};
+
+#endif /* ofxLTC_tools_Synth_h */
@@ -0,0 +1,1071 @@
+//
+//  ltc_bench.cpp
+//  ofxLTC tools
+//
+//  ltc_bench decode [max_channels] [max_threads] [buffer_size]
+//      ParallelDecoder scaling over 1..max_channels channels and 1..max_threads workers
+//
+//  ltc_bench batch [max_lanes] [buffer_size]
+//      one LTCDecoder per channel vs. LTCBatchDecoder on a single core
+//
+//  ltc_bench cores [max_instances] [max_threads] [buffer_size]
+//      N independent decoders + N encoders on M threads, instances created on one thread vs. per worker
+//
+//  ltc_bench offline [max_threads] [minutes]
+//      chunked OfflineDecoder on 1..max_threads threads vs. the sequential decode of a temporary file,
+//      clean and at varispeed with noise
+//
+//  ltc_bench record [channels] [sample_rate] [seconds]
+//      BwfWriter fed in real time with 512 frame buffers, to a temporary 24 bit file
+//
+//  ltc_bench senders [count] [seconds]
+//      count EncoderStreams in one process, each frame located in full vs. incremented,
+//      every channel decoded back and checked against its own timecode
+//
+//  ltc_bench drift [hours]
+//      frame starts of the encoder and of a multi-rate Generator at fractional and
+//      pulled rates over hours of output, against the exact sample_rate / fps
+//
+//  ltc_bench snapshot [readers] [seconds]
+//      an encoding thread publishing every frame it starts to reader threads,
+//      through a SeqLock vs. a mutex, each snapshot read checked for tearing.
+//      then a Sender played by a fake audio thread at 8x real time, directly and
+//      rendering ahead, while readers call getTimecode and a UI thread locates
+//      it with setTimecode every millisecond.
+//      build with CXXFLAGS="-O1 -g -fsanitize=thread" LDFLAGS=-fsanitize=thread
+//      to run it under ThreadSanitizer
+//
+//  ltc_bench renderahead [seconds]
+//      RenderAheadRing restarted every 10 frames, by one request or several back to back
+//      between two callbacks; fails if a replaced generation is still played
+//
+
+#include "Synth.h"
+#include "ofxLTC.h"
+#include "ofxLTC/BwfWriter.h"
+#include "ofxLTC/EncoderStream.h"
+#include "ofxLTC/Generator.h"
+#include "ofxLTC/OfflineDecoder.h"
+#include "ofxLTC/ParallelDecoder.h"
+#include "ofxLTC/RenderAhead.h"
+#include "ofxLTC/SeqLock.h"
+#include "ofxLTC/TimecodeSnapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#   include <linux/perf_event.h>
+#   include <sys/ioctl.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
+
+namespace {
+    using clock_type = std::chrono::steady_clock;
+    
+    double seconds(clock_type::time_point from, clock_type::time_point to)
+    { return std::chrono::duration<double>(to - from).count(); }
+    
+    int argInt(int argc, char *argv[], int index, int fallback)
+    { return index < argc ? std::atoi(argv[index]) : fallback; }
+    
+    // 1, 2, 4, ... up to and including max
+    std::vector<std::size_t> steps(std::size_t max) {
+        std::vector<std::size_t> result;
+        for(std::size_t n = 1; n < max; n *= 2) result.push_back(n);
+        result.push_back(std::max<std::size_t>(1, max));
+        return result;
+    }
+    
+    int benchDecode(int argc, char *argv[]) {
+        const std::size_t max_channels = argInt(argc, argv, 2, 64);
+        const std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+        const std::size_t max_threads = argInt(argc, argv, 3, static_cast<int>(hw));
+        const std::size_t buffer_size = argInt(argc, argv, 4, 64);
+        const double sample_rate = 48000.0;
+        const std::vector<float> mono = synth::ltc(250, sample_rate); // 10 seconds
+        const double audio_seconds = mono.size() / sample_rate;
+        
+        std::printf("# ParallelDecoder, %zu sample buffers, %.1f s of audio, %zu hardware threads\n",
+                    buffer_size, audio_seconds, hw);
+        std::printf("%8s %8s %12s %12s %14s %10s %10s\n",
+                    "channels", "threads", "x realtime", "ch x rt", "max batch us", "overruns", "frames");
+        for(std::size_t channels : steps(max_channels)) {
+            const std::vector<float> input = synth::interleave(mono, channels);
+            for(std::size_t threads : steps(max_threads)) {
+                ofx::LTC::ParallelDecoder decoder(channels, threads);
+                std::size_t frames = 0;
+                decoder.onFrame([&](std::size_t, const LTCFrameExt &) { ++frames; });
+                
+                const auto start = clock_type::now();
+                for(std::size_t pos = 0, n = 0; pos + buffer_size <= mono.size(); pos += buffer_size, ++n) {
+                    // faster than realtime: let the queue fill, then wait instead of dropping
+                    if(n % 4 == 0) decoder.flush();
+                    decoder.process(input.data() + pos * channels, buffer_size, channels, pos);
+                }
+                decoder.flush();
+                const double elapsed = seconds(start, clock_type::now());
+                const auto stats = decoder.getStats();
+                std::printf("%8zu %8zu %12.1f %12.1f %14.1f %10zu %10zu\n",
+                            channels, threads,
+                            audio_seconds / elapsed,
+                            channels * audio_seconds / elapsed,
+                            stats.max_batch * 1e6,
+                            stats.overruns, frames);
+            }
+        }
+        return 0;
+    }
+    
+    int benchBatch(int argc, char *argv[]) {
+        const std::size_t max_lanes = argInt(argc, argv, 2, 64);
+        const std::size_t buffer_size = argInt(argc, argv, 3, 64);
+        const double sample_rate = 48000.0;
+        const std::vector<float> mono = synth::ltc(250, sample_rate);
+        const double audio_seconds = mono.size() / sample_rate;
+        
+        std::printf("# LTCDecoder per channel vs. LTCBatchDecoder, %zu sample buffers, %.1f s of audio\n",
+                    buffer_size, audio_seconds);
+        std::printf("%8s %14s %14s %10s %10s %10s\n",
+                    "channels", "scalar ch x rt", "batch ch x rt", "speedup", "frames", "batch");
+        for(std::size_t lanes : steps(max_lanes)) {
+            const std::vector<float> input = synth::interleave(mono, lanes);
+            std::vector<float> channel(buffer_size);
+            LTCFrameExt frame;
+            
+            std::vector<LTCDecoder *> decoders;
+            for(std::size_t l = 0; l < lanes; ++l) decoders.push_back(ltc_decoder_create(1920, 32));
+            std::size_t scalar_frames = 0;
+            auto start = clock_type::now();
+            for(std::size_t pos = 0; pos + buffer_size <= mono.size(); pos += buffer_size) {
+                const float *block = input.data() + pos * lanes;
+                for(std::size_t l = 0; l < lanes; ++l) {
+                    for(std::size_t i = 0; i < buffer_size; ++i) channel[i] = block[i * lanes + l];
+                    ltc_decoder_write_float(decoders[l], channel.data(), buffer_size, pos);
+                    while(ltc_decoder_read(decoders[l], &frame)) ++scalar_frames;
+                }
+            }
+            const double scalar = seconds(start, clock_type::now());
+            for(LTCDecoder *decoder : decoders) ltc_decoder_free(decoder);
+            
+            LTCBatchDecoder *batch = ltc_batch_decoder_create(static_cast<int>(lanes), 1920, 32);
+            std::size_t batch_frames = 0;
+            start = clock_type::now();
+            for(std::size_t pos = 0; pos + buffer_size <= mono.size(); pos += buffer_size) {
+                ltc_batch_decoder_write_float(batch, const_cast<float *>(input.data() + pos * lanes), buffer_size, lanes, pos);
+                for(std::size_t l = 0; l < lanes; ++l) {
+                    while(ltc_batch_decoder_read(batch, static_cast<int>(l), &frame)) ++batch_frames;
+                }
+            }
+            const double batched = seconds(start, clock_type::now());
+            ltc_batch_decoder_free(batch);
+            
+            std::printf("%8zu %14.1f %14.1f %10.2f %10zu %10zu\n",
+                        lanes,
+                        lanes * audio_seconds / scalar,
+                        lanes * audio_seconds / batched,
+                        scalar / batched,
+                        scalar_frames, batch_frames);
+        }
+        return 0;
+    }
+    
+    // hardware cache misses of the calling thread, -1 where perf events are unavailable
+    struct CacheMissCounter {
+        CacheMissCounter() {
+#ifdef __linux__
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+        };
+        ~CacheMissCounter() {
+#ifdef __linux__
+            if(0 <= fd) close(fd);
+#endif
+        };
+        CacheMissCounter(const CacheMissCounter &) = delete;
+        CacheMissCounter &operator=(const CacheMissCounter &) = delete;
+        
+        void start() {
+#ifdef __linux__
+            if(fd < 0) return;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+        };
+        std::int64_t stop() {
+#ifdef __linux__
+            if(fd < 0) return -1;
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            std::uint64_t count = 0;
+            if(read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+            return static_cast<std::int64_t>(count);
+#else
+            return -1;
+#endif
+        };
+    private:
+        int fd{-1};
+    };
+    
+    // one decoder and one encoder with the bookkeeping a host would keep next to them
+    struct Instance {
+        LTCDecoder *decoder{nullptr};
+        LTCEncoder *encoder{nullptr};
+        ltcsnd_sample_t *encoded{nullptr};
+        std::size_t pending{0};
+        std::size_t frames{0};
+        
+        void create(double sample_rate, double fps) {
+            decoder = ltc_decoder_create(static_cast<int>(sample_rate / fps), 32);
+            encoder = ltc_encoder_create(sample_rate, fps, LTC_TV_625_50, LTC_USE_DATE);
+            encoded = new ltcsnd_sample_t[ltc_encoder_get_buffersize(encoder)];
+        };
+        void destroy() {
+            ltc_decoder_free(decoder);
+            ltc_encoder_free(encoder);
+            delete[] encoded;
+        };
+        
+        void process(const float *input, std::size_t size, std::size_t position) {
+            ltc_decoder_write_float(decoder, const_cast<float *>(input), size, position);
+            LTCFrameExt frame;
+            while(ltc_decoder_read(decoder, &frame)) ++frames;
+            while(pending < size) {
+                ltc_encoder_encode_frame(encoder);
+                pending += ltc_encoder_get_buffer(encoder, encoded);
+                ltc_encoder_inc_timecode(encoder);
+            }
+            pending -= size;
+        };
+    };
+    
+    struct CoreResult {
+        clock_type::time_point finished;
+        double elapsed{0.0};
+        std::int64_t cache_misses{0};
+        std::size_t frames{0};
+        std::vector<double> latencies;
+    };
+    
+    // shared: all instances are created back to back on the calling thread and
+    // handed out round robin, so neighbours in memory run on different threads.
+    // per-thread: every worker creates its own instances, the libltc state comes
+    // from that thread's malloc arena and the bookkeeping from its own vector.
+    // libltc allocates its state itself, so this is as far as placement goes.
+    CoreResult runCores(const std::vector<float> &mono, std::size_t instances, std::size_t threads, std::size_t buffer_size, bool per_thread) {
+        const double sample_rate = 48000.0;
+        const double fps = 25.0;
+        const std::size_t buffers = mono.size() / buffer_size;
+        
+        std::vector<Instance> shared(per_thread ? 0 : instances);
+        for(Instance &instance : shared) instance.create(sample_rate, fps);
+        
+        std::vector<CoreResult> results(threads);
+        std::atomic<std::size_t> ready{0};
+        std::atomic<bool> go{false};
+        
+        auto worker = [&](std::size_t t) {
+            std::vector<Instance *> mine;
+            std::vector<Instance> own;
+            if(per_thread) {
+                own.resize((instances - t + threads - 1) / threads);
+                for(Instance &instance : own) {
+                    instance.create(sample_rate, fps);
+                    mine.push_back(&instance);
+                }
+            } else {
+                for(std::size_t k = t; k < instances; k += threads) mine.push_back(&shared[k]);
+            }
+            CoreResult &result = results[t];
+            result.latencies.reserve(buffers * mine.size());
+            CacheMissCounter counter;
+            
+            ++ready;
+            while(!go.load()) std::this_thread::yield();
+            
+            counter.start();
+            for(std::size_t b = 0; b < buffers; ++b) {
+                const std::size_t position = b * buffer_size;
+                for(Instance *instance : mine) {
+                    const auto before = clock_type::now();
+                    instance->process(mono.data() + position, buffer_size, position);
+                    result.latencies.push_back(seconds(before, clock_type::now()));
+                }
+            }
+            result.finished = clock_type::now();
+            result.cache_misses = counter.stop();
+            
+            for(Instance *instance : mine) result.frames += instance->frames;
+            if(per_thread) for(Instance *instance : mine) instance->destroy();
+        };
+        
+        std::vector<std::thread> pool;
+        for(std::size_t t = 0; t < threads; ++t) pool.emplace_back(worker, t);
+        while(ready.load() < threads) std::this_thread::yield();
+        const auto start = clock_type::now();
+        go = true;
+        for(std::thread &thread : pool) thread.join();
+        for(Instance &instance : shared) instance.destroy();
+        
+        CoreResult total;
+        for(CoreResult &result : results) {
+            total.elapsed = std::max(total.elapsed, seconds(start, result.finished));
+            total.frames += result.frames;
+            if(result.cache_misses < 0 || total.cache_misses < 0) total.cache_misses = -1;
+            else total.cache_misses += result.cache_misses;
+            total.latencies.insert(total.latencies.end(), result.latencies.begin(), result.latencies.end());
+        }
+        std::sort(total.latencies.begin(), total.latencies.end());
+        return total;
+    }
+    
+    double percentile(const std::vector<double> &sorted, double p) {
+        if(sorted.empty()) return 0.0;
+        return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(p * sorted.size()))];
+    }
+    
+    int benchCores(int argc, char *argv[]) {
+        const std::size_t max_instances = argInt(argc, argv, 2, 64);
+        const std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+        const std::size_t max_threads = argInt(argc, argv, 3, static_cast<int>(hw));
+        const std::size_t buffer_size = argInt(argc, argv, 4, 256);
+        const double sample_rate = 48000.0;
+        const std::vector<float> mono = synth::ltc(125, sample_rate); // 5 seconds
+        
+        std::printf("# N decoders + N encoders on M threads, %zu sample buffers, %.1f s of audio, %zu hardware threads\n",
+                    buffer_size, mono.size() / sample_rate, hw);
+        std::printf("# samples/s/core counts decoded plus encoded samples over min(threads, hardware threads) cores\n");
+        std::printf("%9s %8s %10s %16s %10s %10s %10s %16s %8s\n",
+                    "instances", "threads", "placement", "Msamples/s/core", "p50 us", "p99 us", "max us", "misses/Msample", "frames");
+        for(std::size_t instances : steps(max_instances)) {
+            for(std::size_t threads : steps(std::min(max_threads, instances))) {
+                for(int per_thread = 0; per_thread < 2; ++per_thread) {
+                    const CoreResult result = runCores(mono, instances, threads, buffer_size, per_thread);
+                    const double samples = 2.0 * instances * (mono.size() / buffer_size) * buffer_size;
+                    const double cores = static_cast<double>(std::min(threads, hw));
+                    char misses[32];
+                    if(result.cache_misses < 0) std::snprintf(misses, sizeof(misses), "n/a");
+                    else std::snprintf(misses, sizeof(misses), "%.1f", result.cache_misses / (samples * 1e-6));
+                    std::printf("%9zu %8zu %10s %16.2f %10.2f %10.2f %10.2f %16s %8zu\n",
+                                instances, threads, per_thread ? "per-thread" : "shared",
+                                samples / result.elapsed / cores * 1e-6,
+                                percentile(result.latencies, 0.5) * 1e6,
+                                percentile(result.latencies, 0.99) * 1e6,
+                                (result.latencies.empty() ? 0.0 : result.latencies.back()) * 1e6,
+                                misses, result.frames);
+                }
+            }
+        }
+        return 0;
+    }
+    
+    int benchOffline(int argc, char *argv[]) {
+        const std::size_t max_threads = argInt(argc, argv, 2, 16);
+        const int minutes = std::max(1, argInt(argc, argv, 3, 10));
+        const double sample_rate = 48000.0;
+        const char *path = "ltc_bench_offline.raw";
+        const std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+        
+        // clean, then +-20% varispeed twice a second with noise at 3/4 of the level
+        for(int varispeed = 0; varispeed < 2; ++varispeed) {
+            {
+                // 16 bit mono, one minute of LTC at a time
+                std::FILE *out = std::fopen(path, "wb");
+                if(!out) {
+                    std::fprintf(stderr, "ltc_bench: cannot write %s\n", path);
+                    return 1;
+                }
+                std::vector<float> minute = synth::ltc(60 * 25, sample_rate);
+                if(varispeed) minute = synth::varispeed(minute, 0.2, 0.5, 0.75f, sample_rate);
+                std::vector<std::int16_t> pcm(minute.size());
+                for(std::size_t i = 0; i < minute.size(); ++i) {
+                    pcm[i] = static_cast<std::int16_t>(std::lrint(std::max(-1.0f, std::min(1.0f, minute[i] * 0.5f)) * 32767));
+                }
+                for(int m = 0; m < minutes; ++m) std::fwrite(pcm.data(), sizeof(std::int16_t), pcm.size(), out);
+                std::fclose(out);
+            }
+            ofx::LTC::AudioFile file;
+            file.openRaw(path, ofx::LTC::AudioFile::Format::S16, 1, sample_rate);
+            const double audio_seconds = file.getNumFrames() / sample_rate;
+            
+            std::vector<LTCFrameExt> reference;
+            double sequential = 0.0;
+            std::printf("%s# OfflineDecoder, %d minutes of 16 bit mono LTC%s (%s), %zu hardware threads\n",
+                        varispeed ? "\n" : "", minutes, varispeed ? " at varispeed with noise" : "",
+                        file.isMapped() ? "mapped" : "streamed", hw);
+            std::printf("%8s %12s %10s %11s %8s %10s %12s %10s\n",
+                        "threads", "x realtime", "speedup", "efficiency", "chunks", "redecoded", "redecoded s", "identical");
+            for(std::size_t threads : steps(max_threads)) {
+                ofx::LTC::OfflineDecoder::Settings settings;
+                settings.threads = threads;
+                ofx::LTC::OfflineDecoder decoder(file, settings);
+                std::vector<LTCFrameExt> frames;
+                frames.reserve(minutes * 60 * 25);
+                decoder.onFrame([&](const LTCFrameExt &f) { frames.push_back(f); });
+                
+                const auto start = clock_type::now();
+                decoder.decode();
+                const double elapsed = seconds(start, clock_type::now());
+                if(threads == 1) {
+                    reference = frames;
+                    sequential = elapsed;
+                }
+                bool identical = frames.size() == reference.size();
+                for(std::size_t i = 0; identical && i < frames.size(); ++i) {
+                    identical = ofx::LTC::sameFrame(frames[i], reference[i]);
+                }
+                const auto stats = decoder.getStats();
+                std::printf("%8zu %12.0f %10.2f %10.0f%% %8zu %10zu %12.1f %10s\n",
+                            threads, audio_seconds / elapsed, sequential / elapsed,
+                            100.0 * sequential / elapsed / std::min(threads, hw),
+                            stats.chunks, stats.redecoded, stats.redecoded_samples / sample_rate,
+                            identical ? "yes" : "NO");
+            }
+            file.close();
+            std::remove(path);
+        }
+        return 0;
+    }
+    
+    int benchRecord(int argc, char *argv[]) {
+        const std::size_t channels = std::max(1, argInt(argc, argv, 2, 64));
+        const double sample_rate = std::max(8000, argInt(argc, argv, 3, 96000));
+        const int duration = std::max(1, argInt(argc, argv, 4, 30));
+        const std::size_t buffer_size = 512;
+        const char *path = "ltc_bench_record.wav";
+        
+        ofx::LTC::BwfWriter writer;
+        ofx::LTC::BwfWriter::Settings settings;
+        settings.path = path;
+        settings.sample_rate = sample_rate;
+        settings.num_channels = channels;
+        if(!writer.open(settings)) {
+            std::fprintf(stderr, "ltc_bench: %s\n", writer.getError().c_str());
+            return 1;
+        }
+        std::vector<float> buffer(buffer_size * channels);
+        for(std::size_t i = 0; i < buffer.size(); ++i) buffer[i] = std::sin(i * 0.01f) * 0.5f;
+        
+        // the audio thread's side: on time, never waiting for the disk
+        const std::size_t count = static_cast<std::size_t>(duration * sample_rate / buffer_size);
+        std::vector<double> latency;
+        latency.reserve(count);
+        std::size_t peak = 0;
+        const auto start = clock_type::now();
+        for(std::size_t k = 0; k < count; ++k) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(k * buffer_size / sample_rate)));
+            const auto t0 = clock_type::now();
+            writer.write(buffer.data(), buffer_size);
+            latency.push_back(seconds(t0, clock_type::now()) * 1e6);
+            peak = std::max(peak, writer.getBuffered());
+        }
+        const std::uint64_t frames = count * buffer_size;
+        const std::uint64_t overruns = writer.getOverruns();
+        const auto closing = clock_type::now();
+        writer.close();
+        const double drain = seconds(closing, clock_type::now());
+        
+        ofx::LTC::AudioFile file;
+        const bool readable = file.open(path) && file.getNumFrames() == static_cast<std::int64_t>(frames - overruns);
+        file.close();
+        std::remove(path);
+        
+        std::sort(latency.begin(), latency.end());
+        std::printf("# BwfWriter, %zu channels at %.0f Hz, 24 bit, %d s in %zu frame buffers, %.1f MB/s\n",
+                    channels, sample_rate, duration, buffer_size, frames * channels * 3 / 1e6 / duration);
+        std::printf("%10s %12s %12s %12s %12s %12s %10s\n",
+                    "overruns", "peak fill", "write p50", "write p99", "write max", "drain", "readable");
+        std::printf("%10llu %11.1f%% %10.1fus %10.1fus %10.1fus %11.3fs %10s\n",
+                    static_cast<unsigned long long>(overruns), 100.0 * peak / writer.getCapacity(),
+                    latency[latency.size() / 2], latency[latency.size() * 99 / 100], latency.back(),
+                    drain, readable ? "yes" : "NO");
+        return overruns ? 1 : 0;
+    }
+    
+    struct SenderResult {
+        std::vector<double> latencies; // per callback, sorted
+        double elapsed{0.0};
+        std::size_t frames{0}; // decoded
+        std::size_t errors{0}; // decoded frames that weren't the next of their channel
+    };
+    
+    // count streams at mixed frame rates, stream k starting at k o'clock,
+    // rendered into one interleaved buffer per 256 sample callback
+    SenderResult runSenders(std::size_t count, int duration, bool increment) {
+        const double sample_rate = 48000.0;
+        const int buffer_size = 256;
+        const double rates[] = { 24.0, 25.0, 29.97, 30.0 };
+        const int flags = LTC_USE_DATE;
+        
+        std::vector<std::unique_ptr<ofx::LTC::EncoderStream>> streams;
+        std::vector<LTCFrame> next(count), expected(count);
+        std::vector<bool> started(count, false);
+        std::vector<LTCDecoder *> decoders(count);
+        for(std::size_t k = 0; k < count; ++k) {
+            const double fps = rates[k % 4];
+            const bool drop_frame = fps == 29.97;
+            streams.emplace_back(new ofx::LTC::EncoderStream());
+            streams[k]->setup(sample_rate, fps, LTC_TV_525_60, flags);
+            SMPTETimecode start;
+            std::memset(&start, 0, sizeof(start));
+            std::strcpy(start.timezone, "+0000");
+            start.years = 26;
+            start.months = 10;
+            start.days = 18;
+            start.hours = static_cast<unsigned char>(k % 24);
+            std::memset(&next[k], 0, sizeof(LTCFrame));
+            next[k].dfbit = drop_frame ? 1 : 0;
+            ltc_time_to_frame(&next[k], &start, LTC_TV_525_60, flags);
+            expected[k] = next[k];
+            decoders[k] = ltc_decoder_create(static_cast<int>(sample_rate / fps), 32);
+        }
+        
+        SenderResult result;
+        const std::size_t callbacks = static_cast<std::size_t>(duration * sample_rate / buffer_size);
+        result.latencies.reserve(callbacks);
+        std::vector<float> out(buffer_size * count), mono(buffer_size);
+        const auto start = clock_type::now();
+        for(std::size_t c = 0; c < callbacks; ++c) {
+            const auto t0 = clock_type::now();
+            for(std::size_t k = 0; k < count; ++k) {
+                ofx::LTC::EncoderStream &stream = *streams[k];
+                const int fps = static_cast<int>(std::lrint(stream.getFps()));
+                stream.render(out.data() + k, buffer_size, static_cast<int>(count), [&](int) {
+                    SMPTETimecode time;
+                    ltc_frame_to_time(&time, &next[k], flags);
+                    if(increment) stream.show(time, next[k].dfbit != 0);
+                    else stream.locate(time, next[k].dfbit != 0);
+                    ltc_frame_increment(&next[k], fps, LTC_TV_525_60, flags);
+                });
+            }
+            result.latencies.push_back(seconds(t0, clock_type::now()));
+            
+            for(std::size_t k = 0; k < count; ++k) {
+                for(int i = 0; i < buffer_size; ++i) mono[i] = out[i * count + k];
+                ltc_decoder_write_float(decoders[k], mono.data(), buffer_size, static_cast<ltc_off_t>(c * buffer_size));
+                const auto same = [&](const LTCFrame &a, const LTCFrame &b) {
+                    SMPTETimecode ta, tb;
+                    ltc_frame_to_time(&ta, const_cast<LTCFrame *>(&a), flags);
+                    ltc_frame_to_time(&tb, const_cast<LTCFrame *>(&b), flags);
+                    return a.dfbit == b.dfbit && std::memcmp(&ta, &tb, sizeof(SMPTETimecode)) == 0;
+                };
+                LTCFrameExt frame;
+                while(ltc_decoder_read(decoders[k], &frame)) {
+                    ++result.frames;
+                    // the first frame may be missed while the decoder locks on
+                    if(!started[k] && !same(frame.ltc, expected[k])) {
+                        ltc_frame_increment(&expected[k], static_cast<int>(std::lrint(streams[k]->getFps())), LTC_TV_525_60, flags);
+                    }
+                    started[k] = true;
+                    if(!same(frame.ltc, expected[k])) {
+                        ++result.errors;
+                        expected[k] = frame.ltc;
+                    }
+                    ltc_frame_increment(&expected[k], static_cast<int>(std::lrint(streams[k]->getFps())), LTC_TV_525_60, flags);
+                }
+            }
+        }
+        result.elapsed = seconds(start, clock_type::now());
+        for(LTCDecoder *decoder : decoders) ltc_decoder_free(decoder);
+        std::sort(result.latencies.begin(), result.latencies.end());
+        return result;
+    }
+    
+    int benchSenders(int argc, char *argv[]) {
+        const std::size_t count = std::max(1, argInt(argc, argv, 2, 16));
+        const int duration = std::max(1, argInt(argc, argv, 3, 60));
+        
+        std::printf("# %zu EncoderStreams at 48 kHz, 24 / 25 / 29.97 DF / 30 fps, %d s in 256 frame callbacks\n",
+                    count, duration);
+        std::printf("# render time only, decoding every channel back is not timed\n");
+        std::printf("%10s %12s %12s %12s %12s %10s %10s\n",
+                    "frames by", "x realtime", "cb p50", "cb p99", "cb max", "decoded", "errors");
+        std::size_t errors = 0;
+        for(int increment = 0; increment < 2; ++increment) {
+            const SenderResult result = runSenders(count, duration, increment);
+            double rendering = 0.0;
+            for(double latency : result.latencies) rendering += latency;
+            std::printf("%10s %12.0f %10.2fus %10.2fus %10.2fus %10zu %10zu\n",
+                        increment ? "increment" : "locate", duration / rendering,
+                        percentile(result.latencies, 0.5) * 1e6,
+                        percentile(result.latencies, 0.99) * 1e6,
+                        result.latencies.back() * 1e6, result.frames, result.errors);
+            errors += result.errors;
+        }
+        return errors ? 1 : 0;
+    }
+    
+    struct DriftCase {
+        const char *name;
+        double sample_rate, fps; // as handed to the encoder
+        long long sr_num, sr_den, fps_num, fps_den; // the rates they stand for
+    };
+    
+    // floor(k * num / den + 0.5), in parts that don't overflow
+    std::int64_t exactStart(std::int64_t k, long long num, long long den) {
+        const long long q = k / den, r = k % den;
+        return q * num + (2 * r * num + den) / (2 * den);
+    }
+    
+    long long gcd(long long a, long long b) {
+        while(b) {
+            const long long t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+    
+    int benchDrift(int argc, char *argv[]) {
+        const int hours = std::max(1, argInt(argc, argv, 2, 24));
+        const DriftCase cases[] = {
+            { "48k 24", 48000.0, 24.0, 48000, 1, 24, 1 },
+            { "48k 25", 48000.0, 25.0, 48000, 1, 25, 1 },
+            { "48k 29.97", 48000.0, 29.97, 48000, 1, 30000, 1001 },
+            { "48k 23.976", 48000.0, 23.976, 48000, 1, 24000, 1001 },
+            { "48k 59.94", 48000.0, 59.94, 48000, 1, 60000, 1001 },
+            { "44.1k 29.97", 44100.0, 29.97, 44100, 1, 30000, 1001 },
+            { "44.1k 25", 44100.0, 25.0, 44100, 1, 25, 1 },
+            { "47.952k 30", 48000000.0 / 1001.0, 30.0, 48000000, 1001, 30, 1 },
+            { "47.952k 24", 48000000.0 / 1001.0, 24.0, 48000000, 1001, 24, 1 },
+            { "96k 29.97", 96000.0, 29.97, 96000, 1, 30000, 1001 },
+        };
+        
+        std::printf("# %d h of frames per rate, frame k expected at floor(k * sample_rate / fps + 0.5)\n", hours);
+        std::printf("# float accounting: the per half-bit double remainder of sample_rate / fps as given\n");
+        std::printf("%12s %10s %6s %14s %14s %18s\n",
+                    "rate", "frames", "exact", "max error", "drift", "float accounting");
+        bool failed = false;
+        std::vector<unsigned char> buffer;
+        for(const DriftCase &c : cases) {
+            long long num = c.sr_num * c.fps_den, den = c.sr_den * c.fps_num;
+            const long long g = gcd(num, den);
+            num /= g;
+            den /= g;
+            
+            LTCEncoder *encoder = ltc_encoder_create(c.sample_rate, c.fps, LTC_TV_525_60, 0);
+            long long encoder_num = 0, encoder_den = 0;
+            const bool exact = ltc_encoder_get_frame_length(encoder, &encoder_num, &encoder_den) == 0
+                && encoder_num == num && encoder_den == den;
+            buffer.resize(static_cast<std::size_t>(num / den + 2));
+            
+            const std::int64_t frames = static_cast<std::int64_t>(hours) * 3600 * c.fps_num / c.fps_den;
+            std::int64_t position = 0, max_error = 0;
+            for(std::int64_t k = 0; k < frames; ++k) {
+                max_error = std::max<std::int64_t>(max_error, std::llabs(position - exactStart(k, num, den)));
+                position += ltc_encoder_encode_samples(encoder, buffer.data(), static_cast<int>(buffer.size()), 1);
+                ltc_encoder_inc_timecode(encoder);
+            }
+            ltc_encoder_free(encoder);
+            const std::int64_t drift = position - exactStart(frames, num, den);
+            
+            // what the same frames came to with a floating point remainder
+            const double half = c.sample_rate / (c.fps * 160.0);
+            double remainder = 0.5;
+            std::int64_t legacy = 0;
+            for(std::int64_t k = 0; k < frames; ++k) {
+                for(int h = 0; h < 160; ++h) {
+                    const int n = static_cast<int>(half + remainder);
+                    remainder = half + remainder - n;
+                    legacy += n;
+                }
+            }
+            const std::int64_t legacy_drift = legacy - exactStart(frames, num, den);
+            
+            std::printf("%12s %10lld %6s %14lld %14lld %10lld (%.1f ms)\n",
+                        c.name, static_cast<long long>(frames), exact ? "yes" : "NO",
+                        static_cast<long long>(max_error), static_cast<long long>(drift),
+                        static_cast<long long>(legacy_drift), legacy_drift * 1000.0 * c.sr_den / c.sr_num);
+            failed |= !exact || max_error != 0 || drift != 0;
+        }
+        
+        // one Generator, every frame start checked against its stream's exact rate
+        const double sample_rate = 48000.0;
+        const std::size_t buffer_size = 4096;
+        ofx::LTC::Generator generator;
+        generator.setup(sample_rate, buffer_size);
+        const std::size_t streams = 5; // the 48 kHz cases
+        for(std::size_t k = 0; k < streams; ++k) {
+            ofx::LTC::Generator::StreamSettings settings;
+            settings.fps = cases[k].fps;
+            settings.drop_frame = cases[k].fps_num == 30000;
+            settings.channels = std::uint64_t(1) << k;
+            generator.addStream(settings);
+        }
+        std::vector<std::int64_t> next(streams, -1);
+        std::vector<std::size_t> errors(streams, 0), counted(streams, 0);
+        const double start = 1234.5; // seconds after midnight
+        generator.locate(start);
+        generator.start();
+        std::vector<float> out(buffer_size * streams);
+        const std::int64_t total = static_cast<std::int64_t>(hours * 3600.0 * sample_rate);
+        const std::int64_t origin = std::llround(start * sample_rate); // timeline of position 0
+        generator.onFrame([&, origin](std::size_t stream, std::int64_t position, const LTCFrame &) {
+            const DriftCase &c = cases[stream];
+            long long num = c.sr_num * c.fps_den, den = c.sr_den * c.fps_num;
+            const long long g = gcd(num, den);
+            num /= g;
+            den /= g;
+            const std::int64_t at = origin + position;
+            if(next[stream] < 0) {
+                // the first frame to start at or after the locate
+                next[stream] = at * den / num;
+                while(exactStart(next[stream], num, den) < at) ++next[stream];
+            }
+            if(exactStart(next[stream], num, den) != at) ++errors[stream];
+            ++next[stream];
+            ++counted[stream];
+        });
+        const auto t0 = clock_type::now();
+        for(std::int64_t done = 0; done < total; done += buffer_size) {
+            generator.render(out.data(), buffer_size, streams);
+        }
+        const double elapsed = seconds(t0, clock_type::now());
+        std::printf("# Generator, %zu streams at 48 kHz for %d h from %.1f s after midnight, %.0fx realtime\n",
+                    streams, hours, start, hours * 3600.0 / elapsed);
+        std::printf("%12s %10s %14s\n", "rate", "frames", "off timeline");
+        for(std::size_t k = 0; k < streams; ++k) {
+            std::printf("%12s %10zu %14zu\n", cases[k].name, counted[k], errors[k]);
+            failed |= errors[k] != 0;
+        }
+        return failed ? 1 : 0;
+    }
+    
+    struct SnapshotResult {
+        std::vector<double> latencies; // per callback, render and publish, sorted
+        std::size_t frames{0}; // published
+        std::uint64_t reads{0};
+        std::uint64_t torn{0}; // reads whose fields don't belong to one frame
+    };
+    
+    // every frame start of a 25 fps stream published by the encoding thread,
+    // 256 sample callbacks as fast as they render, read back in a loop by readers
+    template <typename Publish, typename Read>
+    SnapshotResult runSnapshot(std::size_t readers, int duration, Publish &&publish, Read &&read) {
+        const double sample_rate = 48000.0;
+        const int buffer_size = 256;
+        const int flags = LTC_USE_DATE;
+        ofx::LTC::EncoderStream stream;
+        stream.setup(sample_rate, 25.0, LTC_TV_625_50, flags);
+        LTCFrame next;
+        std::memset(&next, 0, sizeof(next));
+        
+        SnapshotResult result;
+        std::atomic<bool> running{true};
+        std::atomic<std::uint64_t> reads{0}, torn{0};
+        std::vector<std::thread> threads;
+        for(std::size_t r = 0; r < readers; ++r) {
+            threads.emplace_back([&] {
+                std::uint64_t count = 0, bad = 0;
+                while(running.load(std::memory_order_relaxed)) {
+                    ofx::LTC::TimecodeSnapshot snapshot = read();
+                    SMPTETimecode time;
+                    ltc_frame_to_time(&time, &snapshot.raw_data.ltc, flags);
+                    if(time.hours != snapshot.hour || time.mins != snapshot.min
+                       || time.secs != snapshot.sec || time.frame != snapshot.frame
+                       || snapshot.raw_data.off_start != snapshot.samplePosition) ++bad;
+                    ++count;
+                }
+                reads += count;
+                torn += bad;
+            });
+        }
+        
+        std::vector<float> out(buffer_size);
+        std::int64_t position = 0;
+        const auto start = clock_type::now();
+        while(seconds(start, clock_type::now()) < duration) {
+            const auto t0 = clock_type::now();
+            stream.render(out.data(), buffer_size, 1, [&](int i) {
+                SMPTETimecode time;
+                ltc_frame_to_time(&time, &next, flags);
+                stream.show(time, false);
+                ltc_frame_increment(&next, 25, LTC_TV_625_50, flags);
+                
+                ofx::LTC::TimecodeSnapshot snapshot;
+                std::memset(&snapshot, 0, sizeof(snapshot));
+                snapshot.raw_data.ltc = stream.getFrame();
+                snapshot.raw_data.off_start = position + i;
+                snapshot.setTimezone(time.timezone);
+                snapshot.hour = time.hours;
+                snapshot.min = time.mins;
+                snapshot.sec = time.secs;
+                snapshot.frame = time.frame;
+                snapshot.samplePosition = position + i;
+                publish(snapshot);
+                ++result.frames;
+            });
+            result.latencies.push_back(seconds(t0, clock_type::now()));
+            position += buffer_size;
+        }
+        running = false;
+        for(auto &thread : threads) thread.join();
+        result.reads = reads;
+        result.torn = torn;
+        std::sort(result.latencies.begin(), result.latencies.end());
+        return result;
+    }
+    
+    // the date of every timecode runSenderSnapshot locates to follows its hour,
+    // a read mixing the fields of two of them doesn't
+    bool senderFieldsAgree(const ofx::LTC::Timecode &timecode) {
+        return timecode.year == 2000 + timecode.hour && timecode.month == timecode.hour / 2 + 1
+            && timecode.day == timecode.hour + 1;
+    }
+    
+    // a Sender at 25 fps played in 256 sample callbacks by a fake audio thread,
+    // read by readers through getTimecode and located by a UI thread
+    SnapshotResult runSenderSnapshot(std::size_t readers, int duration, std::size_t render_ahead) {
+        const int buffer_size = 256;
+        const double speed = 8.0; // times real time
+        ofx::LTC::Sender sender;
+        sender.setupEncoder(48000, 25.0f, false, 0, LTC_TV_625_50, LTC_USE_DATE);
+        sender.setTimecode(0, 0, 0, 0, 2000, 1, 1);
+        sender.setRenderAhead(render_ahead);
+        sender.start();
+        
+        SnapshotResult result;
+        std::uint64_t sent_torn = 0;
+        // audio thread: the frame sent and the fields reported with it agree
+        sender.onSend([&](ofx::LTC::Timecode timecode) {
+            SMPTETimecode time;
+            ltc_frame_to_time(&time, &timecode.raw_data.ltc, LTC_USE_DATE);
+            if(!senderFieldsAgree(timecode) || time.hours != timecode.hour || time.mins != timecode.min
+               || time.secs != timecode.sec || time.frame != timecode.frame || time.days != timecode.day) ++sent_torn;
+            ++result.frames;
+        });
+        
+        std::atomic<bool> running{true};
+        std::atomic<std::uint64_t> reads{0}, torn{0};
+        std::vector<std::thread> threads;
+        for(std::size_t r = 0; r < readers; ++r) {
+            threads.emplace_back([&] {
+                std::uint64_t count = 0, bad = 0;
+                while(running.load(std::memory_order_relaxed)) {
+                    if(!senderFieldsAgree(sender.getTimecode())) ++bad;
+                    ++count;
+                }
+                reads += count;
+                torn += bad;
+            });
+        }
+        threads.emplace_back([&] {
+            for(int n = 1; running.load(std::memory_order_relaxed); ++n) {
+                const int hour = n % 24;
+                sender.setTimecode(hour, 0, 0, 0, 2000 + hour, hour / 2 + 1, hour + 1);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        
+        std::thread audio([&] {
+            ofSoundBuffer buffer;
+            buffer.allocate(buffer_size, 2);
+            const auto period = std::chrono::duration_cast<clock_type::duration>(
+                std::chrono::duration<double>(buffer_size / 48000.0 / speed));
+            const auto start = clock_type::now();
+            auto next = start;
+            while(seconds(start, clock_type::now()) < duration) {
+                const auto t0 = clock_type::now();
+                sender.audioOut(buffer);
+                result.latencies.push_back(seconds(t0, clock_type::now()));
+                next += period;
+                std::this_thread::sleep_until(next);
+            }
+        });
+        audio.join();
+        running = false;
+        for(auto &thread : threads) thread.join();
+        sender.onSend(nullptr);
+        result.reads = reads;
+        result.torn = torn + sent_torn;
+        std::sort(result.latencies.begin(), result.latencies.end());
+        return result;
+    }
+    
+    int benchSnapshot(int argc, char *argv[]) {
+        const std::size_t readers = std::max(1, argInt(argc, argv, 2, 3));
+        const int duration = std::max(1, argInt(argc, argv, 3, 5));
+        
+        std::printf("# one encoding thread publishing every frame at 25 fps in 256 sample callbacks, %zu readers, %d s each\n",
+                    readers, duration);
+        std::printf("%10s %10s %12s %10s %10s %10s %10s\n",
+                    "published", "frames", "reads/s", "cb p50", "cb p99", "cb max", "torn");
+        std::uint64_t torn = 0;
+        const auto report = [&](const char *name, const SnapshotResult &result) {
+            std::printf("%10s %10zu %12.0f %8.2fus %8.2fus %8.2fus %10llu\n",
+                        name, result.frames, result.reads / static_cast<double>(duration),
+                        percentile(result.latencies, 0.5) * 1e6,
+                        percentile(result.latencies, 0.99) * 1e6,
+                        result.latencies.back() * 1e6,
+                        static_cast<unsigned long long>(result.torn));
+            torn += result.torn;
+        };
+        
+        {
+            ofx::LTC::SeqLock<ofx::LTC::TimecodeSnapshot> published;
+            report("seqlock", runSnapshot(readers, duration,
+                                          [&](const ofx::LTC::TimecodeSnapshot &snapshot) { published.store(snapshot); },
+                                          [&] { return published.load(); }));
+        }
+        {
+            std::mutex mutex;
+            ofx::LTC::TimecodeSnapshot published;
+            std::memset(&published, 0, sizeof(published));
+            report("mutex", runSnapshot(readers, duration,
+                                        [&](const ofx::LTC::TimecodeSnapshot &snapshot) {
+                                            std::lock_guard<std::mutex> lock(mutex);
+                                            published = snapshot;
+                                        },
+                                        [&] {
+                                            std::lock_guard<std::mutex> lock(mutex);
+                                            return published;
+                                        }));
+        }
+        std::printf("# a Sender played at 8x real time, %zu readers calling getTimecode, setTimecode every ms\n", readers);
+        report("sender", runSenderSnapshot(readers, duration, 0));
+        report("sender+ra4", runSenderSnapshot(readers, duration, 4));
+        return torn ? 1 : 0;
+    }
+    
+    // a frame in the render-ahead bench, stamped with the generation it was rendered for
+    struct RenderedFrame {
+        std::uint32_t generation;
+        int length; // samples
+    };
+    
+    struct RenderAheadResult {
+        std::size_t callbacks{0};
+        std::size_t restarts{0};
+        std::size_t stale{0}; // samples of a replaced generation played after its replacement was due
+        std::size_t silent{0};
+    };
+    
+    // a worker renders frames whose samples are their generation into a
+    // RenderAheadRing, the audio thread reads it in 64 sample callbacks at
+    // 8x real time and requests `requests` restarts back to back every 10 frames.
+    RenderAheadResult runRenderAhead(int requests, int duration) {
+        typedef ofx::LTC::RenderAheadRing<RenderedFrame> Ring;
+        const int frame_length = 1920;
+        const std::size_t callback = 64;
+        Ring ring;
+        ring.allocate(4 * frame_length);
+        
+        std::atomic<bool> running{true};
+        std::thread worker([&] {
+            std::int64_t position = 0, next_start = 0;
+            while(running) {
+                std::int64_t restart;
+                const RenderedFrame *last;
+                if(ring.restarted(restart, last)) {
+                    position = restart;
+                    next_start = restart;
+                }
+                Ring::Block *block = ring.getWorkerGeneration() ? ring.acquire(position) : nullptr;
+                if(!block) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for(std::size_t i = 0; i < Ring::block_size; ++i) {
+                    if(position + static_cast<std::int64_t>(i) == next_start) {
+                        block->start_offset[block->num_starts] = i;
+                        block->start_info[block->num_starts] = RenderedFrame{ring.getWorkerGeneration(), frame_length};
+                        ++block->num_starts;
+                        next_start += frame_length;
+                    }
+                    block->samples[i] = static_cast<float>(ring.getWorkerGeneration());
+                }
+                ring.commit(block);
+                position += Ring::block_size;
+            }
+        });
+        
+        RenderAheadResult result;
+        std::vector<float> out(callback);
+        std::uint32_t requested = 1; // allocate() asks for the first generation
+        std::int64_t due = 0; // from here on nothing older than `requested` may play
+        const std::size_t total = static_cast<std::size_t>(duration * 48000) / callback;
+        const auto start = clock_type::now();
+        for(std::size_t n = 0; n < total; ++n) {
+            const std::int64_t position = static_cast<std::int64_t>(n * callback);
+            if(n && n % (10 * frame_length / callback) == 0) {
+                for(int r = 0; r < requests; ++r) ring.requestRestart();
+                requested += requests;
+                ++result.restarts;
+                // the frame playing finishes first, the new one is rendered in time
+                due = position + static_cast<std::int64_t>(callback) + 2 * frame_length;
+            }
+            ring.read(out.data(), callback, 1, position, [](std::int64_t, const RenderedFrame &) {});
+            for(std::size_t i = 0; i < callback; ++i) {
+                if(out[i] == 0.0f) ++result.silent;
+                else if(due <= position + static_cast<std::int64_t>(i) && out[i] < requested) ++result.stale;
+            }
+            ++result.callbacks;
+            std::this_thread::sleep_until(start + std::chrono::microseconds((n + 1) * callback * 1000000 / (8 * 48000)));
+        }
+        running = false;
+        worker.join();
+        return result;
+    }
+    
+    int benchRenderAhead(int argc, char *argv[]) {
+        const int duration = std::max(1, argInt(argc, argv, 2, 40));
+        std::printf("# RenderAheadRing, 4 frames ahead, %d s of 64 sample callbacks at 8x real time, a restart every 10 frames\n", duration);
+        std::printf("%10s %10s %10s %10s %10s\n", "requests", "callbacks", "restarts", "silent", "stale");
+        std::size_t stale = 0;
+        for(int requests = 1; requests <= 3; ++requests) {
+            const RenderAheadResult result = runRenderAhead(requests, duration);
+            std::printf("%10d %10zu %10zu %10zu %10zu\n",
+                        requests, result.callbacks, result.restarts, result.silent, result.stale);
+            stale += result.stale;
+        }
+        return stale ? 1 : 0;
+    }
+    
+    int usage() {
+        std::fprintf(stderr,
+                     "usage: ltc_bench decode [max_channels] [max_threads] [buffer_size]\n"
+                     "       ltc_bench batch [max_lanes] [buffer_size]\n"
+                     "       ltc_bench cores [max_instances] [max_threads] [buffer_size]\n"
+                     "       ltc_bench offline [max_threads] [minutes]\n"
+                     "       ltc_bench record [channels] [sample_rate] [seconds]\n"
+                     "       ltc_bench senders [count] [seconds]\n"
+                     "       ltc_bench drift [hours]\n"
+                     "       ltc_bench snapshot [readers] [seconds]\n"
+                     "       ltc_bench renderahead [seconds]\n");
+        return 1;
+    }
+};
+
+int main(int argc, char *argv[]) {
+    const std::string mode = 1 < argc ? argv[1] : "decode";
+    if(mode == "decode") return benchDecode(argc, argv);
+    if(mode == "batch") return benchBatch(argc, argv);
+    if(mode == "cores") return benchCores(argc, argv);
+    if(mode == "offline") return benchOffline(argc, argv);
+    if(mode == "record") return benchRecord(argc, argv);
+    if(mode == "senders") return benchSenders(argc, argv);
+    if(mode == "drift") return benchDrift(argc, argv);
+    if(mode == "snapshot") return benchSnapshot(argc, argv);
+    if(mode == "renderahead") return benchRenderAhead(argc, argv);
+    return usage();
+}
@@ -0,0 +1,136 @@
+//
+//  ltc_decode.cpp
+//  ofxLTC tools
+//
+//  ltc_decode [-c channel] [-f fps] [-j threads] [-r format:channels:rate[:offset]] [-b] [-o output] [-i index] file
+//      decodes the LTC on one channel of a WAV / BWF / RF64 or raw PCM file
+//      and writes one line per frame as CSV, or FrameRecords with -b.
+//      -i also writes a TimecodeIndex of the recording
+//
+
+#include "ofxLTC/AudioFile.h"
+#include "ofxLTC/OfflineDecoder.h"
+#include "ofxLTC/TimecodeIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+    int usage() {
+        std::fprintf(stderr,
+                     "usage: ltc_decode [-c channel] [-f fps] [-j threads] [-r format:channels:rate[:offset]] [-b] [-o output] [-i index] file\n"
+                     "  -c  channel to decode, default 0\n"
+                     "  -f  expected frame rate, default 25\n"
+                     "  -j  decode in chunks on this many threads, same output, default 1\n"
+                     "  -r  headerless PCM, format is one of u8 s16 s24 s32 f32 f64\n"
+                     "  -b  binary FrameRecords instead of CSV\n"
+                     "  -o  output file, default stdout\n"
+                     "  -i  also write a timecode index, see ltc_index\n");
+        return 1;
+    }
+    
+    bool openRaw(ofx::LTC::AudioFile &file, const std::string &path, const std::string &spec) {
+        const std::size_t a = spec.find(':');
+        const std::size_t b = spec.find(':', a + 1);
+        if(a == std::string::npos || b == std::string::npos) return false;
+        const std::size_t c = spec.find(':', b + 1);
+        ofx::LTC::AudioFile::Format format;
+        if(!ofx::LTC::AudioFile::parseFormat(spec.substr(0, a), format)) return false;
+        const int channels = std::atoi(spec.substr(a + 1, b - a - 1).c_str());
+        const double rate = std::atof(spec.substr(b + 1, c - b - 1).c_str());
+        const std::uint64_t offset = c == std::string::npos ? 0 : std::strtoull(spec.substr(c + 1).c_str(), nullptr, 10);
+        if(channels <= 0 || rate <= 0.0) return false;
+        return file.openRaw(path, format, channels, rate, offset);
+    }
+    
+    void writeCsv(std::FILE *out, const LTCFrameExt &f, double sample_rate) {
+        LTCFrame frame = f.ltc;
+        SMPTETimecode t;
+        ltc_frame_to_time(&t, &frame, 0);
+        std::fprintf(out, "%lld,%lld,%.6f,%02d:%02d:%02d%c%02d,%d,%.1f\n",
+                     static_cast<long long>(f.off_start), static_cast<long long>(f.off_end),
+                     f.off_start / sample_rate,
+                     t.hours, t.mins, t.secs, frame.dfbit ? ';' : ':', t.frame,
+                     f.reverse ? 1 : 0, f.volume);
+    }
+};
+
+int main(int argc, char *argv[]) {
+    ofx::LTC::OfflineDecoder::Settings settings;
+    std::string raw, output, index, path;
+    bool binary = false;
+    int index_fps = 0; // guessed unless given
+    for(int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if(arg == "-c" && has_value) settings.channel = std::atoi(argv[++i]);
+        else if(arg == "-f" && has_value) {
+            settings.fps = std::atof(argv[++i]);
+            index_fps = static_cast<int>(settings.fps + 0.5);
+        } else if(arg == "-j" && has_value) settings.threads = std::max(1, std::atoi(argv[++i]));
+        else if(arg == "-r" && has_value) raw = argv[++i];
+        else if(arg == "-o" && has_value) output = argv[++i];
+        else if(arg == "-i" && has_value) index = argv[++i];
+        else if(arg == "-b") binary = true;
+        else if(arg[0] == '-' || !path.empty()) return usage();
+        else path = arg;
+    }
+    if(path.empty() || settings.fps <= 0.0) return usage();
+    
+    ofx::LTC::AudioFile file;
+    const bool opened = raw.empty() ? file.open(path) : openRaw(file, path, raw);
+    if(!opened) {
+        std::fprintf(stderr, "ltc_decode: %s\n", raw.empty() || !file.getError().empty() ? file.getError().c_str() : "bad -r spec");
+        return 1;
+    }
+    if(file.getNumChannels() <= settings.channel) {
+        std::fprintf(stderr, "ltc_decode: channel %zu out of range, the file has %zu\n", settings.channel, file.getNumChannels());
+        return 1;
+    }
+    
+    std::FILE *out = output.empty() ? stdout : std::fopen(output.c_str(), binary ? "wb" : "w");
+    if(!out) {
+        std::fprintf(stderr, "ltc_decode: cannot write %s\n", output.c_str());
+        return 1;
+    }
+    
+    const double sample_rate = file.getSampleRate();
+    if(binary) {
+        const ofx::LTC::FrameRecord::Header header = ofx::LTC::FrameRecord::header(sample_rate, settings.channel);
+        std::fwrite(&header, sizeof(header), 1, out);
+    } else {
+        std::fprintf(out, "off_start,off_end,seconds,timecode,reverse,volume_dbfs\n");
+    }
+    
+    ofx::LTC::TimecodeIndexBuilder builder(sample_rate, index_fps);
+    ofx::LTC::OfflineDecoder decoder(file, settings);
+    decoder.onFrame([&](const LTCFrameExt &f) {
+        if(!index.empty()) builder.add(f);
+        if(binary) {
+            const ofx::LTC::FrameRecord record = ofx::LTC::FrameRecord::from(f);
+            std::fwrite(&record, sizeof(record), 1, out);
+        } else {
+            writeCsv(out, f, sample_rate);
+        }
+    });
+    
+    const auto start = std::chrono::steady_clock::now();
+    const std::size_t frames = decoder.decode();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double audio = file.getNumFrames() / sample_rate;
+    std::fprintf(stderr, "ltc_decode: %zu frames in %.1f s of audio (%s), %.3f s, %.0fx realtime\n",
+                 frames, audio, file.isMapped() ? "mapped" : "streamed", elapsed, audio / std::max(elapsed, 1e-9));
+    
+    if(out != stdout) std::fclose(out);
+    if(!index.empty()) {
+        if(!builder.write(index)) {
+            std::fprintf(stderr, "ltc_decode: cannot write %s\n", index.c_str());
+            return 1;
+        }
+        std::fprintf(stderr, "ltc_decode: %zu runs in %s\n", builder.getNumRuns(), index.c_str());
+    }
+    return 0;
+}
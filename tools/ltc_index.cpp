@@ -0,0 +1,87 @@
+//
+//  ltc_index.cpp
+//  ofxLTC tools
+//
+//  ltc_index index [timecode | @sample]...
+//      looks up a TimecodeIndex written by ltc_decode -i. without queries it lists the runs.
+//      timecode is hh:mm:ss:ff, or hh:mm:ss;ff for drop-frame
+//
+
+#include "ofxLTC/TimecodeIndex.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+    int usage() {
+        std::fprintf(stderr,
+                     "usage: ltc_index index [timecode | @sample]...\n"
+                     "  hh:mm:ss:ff   sample offsets of the frame, hh:mm:ss;ff for drop-frame\n"
+                     "  @sample       the frame playing at a sample offset\n");
+        return 1;
+    }
+    
+    std::string label(std::int64_t count, int fps, bool drop_frame) {
+        int h, m, s, f;
+        ofx::LTC::fromFrameCount(count, fps, drop_frame, h, m, s, f);
+        char text[48]; // fits any int in every field
+        std::snprintf(text, sizeof(text), "%02d:%02d:%02d%c%02d", h, m, s, drop_frame ? ';' : ':', f);
+        return text;
+    }
+    
+    void listRuns(const ofx::LTC::TimecodeIndex &index) {
+        std::printf("%12s %12s %12s %12s %10s %8s\n", "sample", "first", "last", "frames", "spf", "reverse");
+        for(std::size_t i = 0; i < index.getNumRuns(); ++i) {
+            const ofx::LTC::TimecodeIndex::Run &run = index.getRun(i);
+            const bool drop_frame = run.drop_frame != 0;
+            std::printf("%12" PRId64 " %12s %12s %12d %10.3f %8s\n",
+                        run.sample,
+                        label(run.label, index.getFps(), drop_frame).c_str(),
+                        label(run.label + run.direction * (run.length - 1), index.getFps(), drop_frame).c_str(),
+                        run.length, run.samples_per_frame, run.direction < 0 ? "yes" : "no");
+        }
+    }
+};
+
+int main(int argc, char *argv[]) {
+    if(argc < 2) return usage();
+    ofx::LTC::TimecodeIndex index;
+    if(!index.open(argv[1])) {
+        std::fprintf(stderr, "ltc_index: cannot read %s\n", argv[1]);
+        return 1;
+    }
+    std::printf("# %zu runs, %d fps, %.0f Hz\n", index.getNumRuns(), index.getFps(), index.getSampleRate());
+    if(argc == 2) {
+        listRuns(index);
+        return 0;
+    }
+    
+    for(int i = 2; i < argc; ++i) {
+        const std::string query = argv[i];
+        if(query[0] == '@') {
+            const std::int64_t sample = std::strtoll(query.c_str() + 1, nullptr, 10);
+            ofx::LTC::TimecodeIndex::Position position;
+            if(index.timecodeAt(sample, position)) {
+                std::printf("%s %s +%.3f%s\n", query.c_str(),
+                            label(position.label, index.getFps(), position.drop_frame).c_str(),
+                            position.phase, position.reverse ? " reverse" : "");
+            } else {
+                std::printf("%s -\n", query.c_str());
+            }
+            continue;
+        }
+        int h, m, s, f;
+        char separator;
+        if(std::sscanf(query.c_str(), "%d:%d:%d%c%d", &h, &m, &s, &separator, &f) != 5) return usage();
+        std::vector<std::int64_t> samples;
+        index.samplesAt(h, m, s, f, separator == ';', samples);
+        std::printf("%s", query.c_str());
+        if(samples.empty()) std::printf(" -");
+        for(std::int64_t sample : samples) std::printf(" %" PRId64, sample);
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+//
+//  ltc_log2csv.cpp
+//  ofxLTC tools
+//
+//  ltc_log2csv file.ltclog...
+//      prints a capture log written by CaptureLogWriter as CSV. rotated files
+//      are given in order and continue one another.
+//
+
+#include "ofxLTC/CaptureLog.h"
+
+#include <cstdio>
+
+namespace {
+    int usage() {
+        std::fprintf(stderr, "usage: ltc_log2csv file.ltclog...\n");
+        return 1;
+    }
+};
+
+int main(int argc, char *argv[]) {
+    if(argc < 2) return usage();
+    std::printf("off_start,off_end,timecode,reverse,extrapolated,volume_dbfs,time\n");
+    std::size_t frames = 0, buffers = 0, skipped = 0;
+    std::uint64_t dropped = 0;
+    for(int i = 1; i < argc; ++i) {
+        ofx::LTC::CaptureLogReader reader;
+        if(!reader.open(argv[i])) {
+            std::fprintf(stderr, "ltc_log2csv: cannot read %s\n", argv[i]);
+            return 1;
+        }
+        ofx::LTC::CaptureEntry entry;
+        while(reader.next(entry)) {
+            if(entry.buffer) {
+                ++buffers;
+                continue;
+            }
+            LTCFrame frame = entry.frame();
+            SMPTETimecode t;
+            ltc_frame_to_time(&t, &frame, 0);
+            std::printf("%lld,%lld,%02d:%02d:%02d%c%02d,%d,%d,%.2f,%.6f\n",
+                        static_cast<long long>(entry.off_start), static_cast<long long>(entry.off_end),
+                        t.hours, t.mins, t.secs, frame.dfbit ? ';' : ':', t.frame,
+                        entry.reverse ? 1 : 0, entry.extrapolated ? 1 : 0, entry.volume, entry.time);
+            ++frames;
+        }
+        skipped += reader.getSkipped();
+        dropped += reader.getDropped();
+    }
+    std::fprintf(stderr, "ltc_log2csv: %zu frames, %zu buffers, %llu dropped while capturing, %zu damaged bytes skipped\n",
+                 frames, buffers, static_cast<unsigned long long>(dropped), skipped);
+    return 0;
+}
@@ -0,0 +1,30 @@
+//
+//  ofLog.h
+//  ofxLTC tools
+//
+//  ofLogNotice() << ... and friends, to stderr
+//
+
+#pragma once
+
+#include <iostream>
+#include <sstream>
+
+class ofLog {
+public:
+    ~ofLog()
+    { std::cerr << message.str() << std::endl; };
+    
+    template <typename T>
+    ofLog &operator<<(const T &value) {
+        message << value;
+        return *this;
+    }
+    
+protected:
+    std::ostringstream message;
+};
+
+class ofLogNotice : public ofLog {};
+class ofLogWarning : public ofLog {};
+class ofLogError : public ofLog {};
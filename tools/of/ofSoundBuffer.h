@@ -0,0 +1,64 @@
+//
+//  ofSoundBuffer.h
+//  ofxLTC tools
+//
+//  the parts of openFrameworks' ofSoundBuffer the addon uses, so the tools
+//  can build the Sender and Receiver without openFrameworks
+//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class ofSoundBuffer {
+public:
+    void allocate(std::size_t num_frames, std::size_t num_channels) {
+        channels = num_channels;
+        buffer.assign(num_frames * num_channels, 0.0f);
+    }
+    
+    std::size_t size() const
+    { return buffer.size(); };
+    
+    std::size_t getNumChannels() const
+    { return channels; };
+    
+    std::size_t getNumFrames() const
+    { return channels ? buffer.size() / channels : 0; };
+    
+    void setSampleRate(unsigned int rate)
+    { sample_rate = rate; };
+    
+    unsigned int getSampleRate() const
+    { return sample_rate; };
+    
+    std::vector<float> &getBuffer()
+    { return buffer; };
+    
+    const std::vector<float> &getBuffer() const
+    { return buffer; };
+    
+    float &operator[](std::size_t i)
+    { return buffer[i]; };
+    
+    const float &operator[](std::size_t i) const
+    { return buffer[i]; };
+    
+protected:
+    std::vector<float> buffer;
+    std::size_t channels{1};
+    unsigned int sample_rate{44100};
+};
+
+class ofBaseSoundInput {
+public:
+    virtual ~ofBaseSoundInput() {}
+    virtual void audioIn(ofSoundBuffer &) {}
+};
+
+class ofBaseSoundOutput {
+public:
+    virtual ~ofBaseSoundOutput() {}
+    virtual void audioOut(ofSoundBuffer &) {}
+};
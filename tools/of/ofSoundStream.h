@@ -0,0 +1,50 @@
+//
+//  ofSoundStream.h
+//  ofxLTC tools
+//
+//  a sound stream that never opens a device: the tools call audioIn /
+//  audioOut themselves
+//
+
+#pragma once
+
+#include "ofSoundBuffer.h"
+
+#include <string>
+#include <vector>
+
+struct ofSoundDevice {
+    std::string name;
+};
+
+class ofSoundStreamSettings {
+public:
+    std::size_t sampleRate{44100};
+    std::size_t bufferSize{256};
+    std::size_t numBuffers{4};
+    std::size_t numInputChannels{0};
+    std::size_t numOutputChannels{0};
+    
+    template <typename Listener>
+    void setInListener(Listener *) {}
+    
+    template <typename Listener>
+    void setOutListener(Listener *) {}
+    
+    const ofSoundDevice *getInDevice() const
+    { return nullptr; };
+    
+    const ofSoundDevice *getOutDevice() const
+    { return nullptr; };
+};
+
+class ofSoundStream {
+public:
+    bool setup(const ofSoundStreamSettings &)
+    { return true; };
+    
+    std::vector<ofSoundDevice> getDeviceList() const
+    { return {}; };
+    
+    void close() {}
+};
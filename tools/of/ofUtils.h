@@ -0,0 +1,45 @@
+//
+//  ofUtils.h
+//  ofxLTC tools
+//
+//  the time and string helpers the addon uses
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+inline std::string ofVAArgsToString(const char *format, ...) {
+    char text[1024];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    return text;
+}
+
+// seconds since the first call
+inline float ofGetElapsedTimef() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline std::tm ofLocalTime() {
+    const std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    return local;
+}
+
+inline int ofGetYear()
+{ return ofLocalTime().tm_year + 1900; };
+
+inline int ofGetMonth()
+{ return ofLocalTime().tm_mon + 1; };
+
+inline int ofGetDay()
+{ return ofLocalTime().tm_mday; };